@@ -0,0 +1,188 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef ALPHABET_HH_INCLUDED
+#define ALPHABET_HH_INCLUDED 1
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * \file alphabet.hh
+ *
+ * \brief Per-character lookup tables for strings of any character type
+ *
+ *
+ */
+
+namespace dl {
+
+  namespace detail {
+
+    /**
+     * \brief A map from the characters of a pair of strings to non-zero
+     * values, with every character initially mapped to zero
+     *
+     *
+     * Several of the algorithms need to look something up by character (the
+     * last row at which each character appeared, in the case of Lowrance &
+     * Wagner; the match vector for each character, in the case of Hyyrö).
+     * When every character of the string whose characters will be set (the
+     * "keys") is less than 256, a dense 256-entry table does the job & costs
+     * no more than indexing an array. Otherwise (UTF-16 or UTF-32 text beyond
+     * Latin-1, say), the map is a compact open-addressing hash table keyed by
+     * the characters of that string, which occupies space proportional to its
+     * length rather than to the size of the alphabet.
+     *
+     * Only those dense entries that will be looked up are cleared, so setting
+     * up the map for a pair of strings costs time linear in their lengths.
+     *
+     *
+     */
+
+    template <typename CharT>
+    class char_map
+    {
+    public:
+      typedef std::make_unsigned_t<CharT> uchar_type;
+      typedef std::basic_string_view<CharT> view_type;
+
+    public:
+      /// Return the number of words of scratch memory needed to map the
+      /// characters of \a K (zero, if the dense table will do)
+      static std::size_t scratch_words(view_type K) {
+        if constexpr (1 == sizeof(CharT)) {
+          return 0;
+        } else {
+          for (CharT c: K) {
+            if ((uchar_type)c > 255) {
+              // Two words (key & value) per slot, with at least twice as many
+              // slots as there are keys
+              std::size_t slots = 8;
+              while (slots < 2 * K.length()) slots <<= 1;
+              return 2 * slots;
+            }
+          }
+          return 0;
+        }
+      }
+
+    public:
+      /**
+       * \brief Set up a map on which set will be called only for characters of
+       * \a K & get only for characters of \a K or \a L
+       *
+       *
+       * \param K [in] the characters that may be set
+       *
+       * \param L [in] further characters that may be looked up
+       *
+       * \param scratch [in] room for scratch_words(K) words, or null if that's
+       * zero
+       *
+       * \param nwords [in] scratch_words(K)
+       *
+       *
+       */
+      char_map(view_type K, view_type L, std::size_t *scratch, std::size_t nwords):
+        slots_(scratch), mask_(0), shift_(0)
+      {
+        if (0 == nwords) {
+          for (CharT c: K) dense_[(uchar_type)c] = 0;
+          for (CharT c: L) {
+            if ((uchar_type)c < 256) dense_[(uchar_type)c] = 0;
+          }
+        } else {
+          init_slots(nwords);
+        }
+      }
+
+      /// Set up a map on which set will be called only for characters of some
+      /// string K (\a nwords being scratch_words(K)), but on which get may be
+      /// called for any character at all
+      char_map(std::size_t *scratch, std::size_t nwords):
+        slots_(scratch), mask_(0), shift_(0)
+      {
+        if (0 == nwords) {
+          for (std::size_t i = 0; i < 256; ++i) dense_[i] = 0;
+        } else {
+          init_slots(nwords);
+        }
+      }
+
+      /// Look up the value for \a c (zero if it was never set)
+      std::size_t get(CharT c) const {
+        if (0 == mask_) {
+          if constexpr (1 == sizeof(CharT)) {
+            return dense_[(uchar_type)c];
+          } else {
+            return (uchar_type)c < 256 ? dense_[(uchar_type)c] : 0;
+          }
+        }
+        // A slot whose value is zero is empty
+        for (std::size_t s = hash(c); ; s = (s + 1) & mask_) {
+          if (0 == slots_[2*s + 1] || (uchar_type)c == slots_[2*s]) {
+            return slots_[2*s + 1];
+          }
+        }
+      }
+
+      /// Map \a c (which must be a character of the string given as the keys
+      /// at construction) to \a x, which must be non-zero
+      void set(CharT c, std::size_t x) {
+        if (0 == mask_) {
+          dense_[(uchar_type)c] = x;
+          return;
+        }
+        std::size_t s = hash(c);
+        while (0 != slots_[2*s + 1] && (uchar_type)c != slots_[2*s]) {
+          s = (s + 1) & mask_;
+        }
+        slots_[2*s] = (uchar_type)c;
+        slots_[2*s + 1] = x;
+      }
+
+    private:
+      void init_slots(std::size_t nwords) {
+        std::size_t n = nwords / 2;
+        mask_ = n - 1;
+        shift_ = 64;
+        while (n > 1) {
+          n >>= 1;
+          --shift_;
+        }
+        for (std::size_t i = 0; i < nwords; ++i) slots_[i] = 0;
+      }
+
+      std::size_t hash(CharT c) const {
+        // Fibonacci hashing: the high bits of the product are well mixed
+        return (std::size_t)((std::uint64_t((uchar_type)c) *
+                              UINT64_C(0x9e3779b97f4a7c15)) >> shift_);
+      }
+
+    private:
+      std::size_t dense_[256];
+      std::size_t *slots_;
+      std::size_t mask_;
+      unsigned shift_;
+    };
+
+  } // namespace detail
+
+} // namespace dl
+
+#endif // ALPHABET_HH_INCLUDED
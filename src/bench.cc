@@ -0,0 +1,438 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "damlev.hh"
+#include "synth.hh"
+
+using dl::algorithm;
+
+// Every allocation made by the program is counted, so that each benchmark can
+// report the allocations made per comparison; once the thread's workspace
+// has grown to fit the longest pair, that should be none.
+namespace {
+  std::atomic<std::size_t> num_allocs(0);
+}
+
+void*
+operator new(std::size_t n)
+{
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void*
+operator new(std::size_t n, std::align_val_t al)
+{
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  std::size_t a = std::max(sizeof(void*), std::size_t(al));
+  void *p;
+  if (0 == posix_memalign(&p, a, n ? n : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void *p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+namespace {
+
+  const struct {
+    const char *name;
+    algorithm algo;
+  } ALGORITHMS[] = {
+    { "lw", algorithm::lw },
+    { "uk", algorithm::uk },
+    { "br", algorithm::br },
+    { "bp", algorithm::bp },
+  };
+
+  /// The parameters of the sweep
+  struct sweep {
+    std::vector<std::size_t> algos;
+    std::vector<std::size_t> lengths;
+    std::vector<double> ratios;
+    std::vector<std::size_t> alphabets;
+    std::size_t pairs;
+    std::size_t repeats;
+    double min_time_ms;
+    std::uint64_t seed;
+  };
+
+  /// The timings from the repeats of one benchmark, in ns per pair
+  struct summary {
+    double median, min, mean, stddev;
+  };
+
+  summary
+  summarize(std::vector<double> x)
+  {
+    using namespace std;
+    sort(x.begin(), x.end());
+    size_t n = x.size();
+    summary s;
+    s.median = n % 2 ? x[n/2] : (x[n/2 - 1] + x[n/2]) / 2;
+    s.min = x[0];
+    s.mean = 0;
+    for (double t: x) s.mean += t;
+    s.mean /= n;
+    s.stddev = 0;
+    for (double t: x) s.stddev += (t - s.mean) * (t - s.mean);
+    s.stddev = 1 < n ? sqrt(s.stddev / (n - 1)) : 0;
+    return s;
+  }
+
+  /**
+   * \brief Time one algorithm over one workload & write the results as a line
+   * of JSON
+   *
+   *
+   * The workload is made afresh by a dl::pair_generator seeded with the same
+   * seed each time, so that it depends only on the parameters (& not, for
+   * instance, on which other benchmarks were run). Long pairs are costly, so
+   * fewer of them are made: \a num_pairs for strings of up to 256
+   * characters, proportionately fewer (but at least one) beyond that.
+   *
+   * The pairs are compared once to warm the workspace & to time a pass over
+   * them, from which the number of passes needed to take the minimum time is
+   * worked out. Each repeat then makes that many passes.
+   *
+   *
+   */
+
+  void
+  run(const sweep &S,
+      std::size_t a,
+      std::size_t length,
+      double ratio,
+      std::size_t alphabet,
+      bool first)
+  {
+    using namespace std;
+    typedef chrono::steady_clock clock_type;
+
+    dl::synth_params params;
+    params.length = length;
+    params.min_edits = params.max_edits =
+      max<size_t>(1, (size_t)llround(ratio * length));
+    params.alphabet = alphabet;
+    dl::pair_generator gen(params, S.seed);
+
+    size_t np = max<size_t>(1, min(S.pairs, S.pairs * 256 / max<size_t>(1,
+                                                                    length)));
+    vector<string> A(np), B(np);
+    double cells = 0;
+    for (size_t i = 0; i < np; ++i) {
+      gen(A[i], B[i]);
+      cells += double(A[i].length()) * B[i].length();
+    }
+
+    algorithm algo = ALGORITHMS[a].algo;
+    dl::workspace &ws = dl::this_thread_workspace();
+    auto pass = [&]() {
+      size_t sum = 0;
+      for (size_t i = 0; i < np; ++i) {
+        sum += dl::distance(A[i], B[i], algo, ws);
+      }
+      return sum;
+    };
+
+    auto then = clock_type::now();
+    size_t total = pass();
+    double once = chrono::duration<double, milli>(clock_type::now() -
+                                                  then).count();
+    size_t iterations = max<size_t>(1, (size_t)ceil(S.min_time_ms /
+                                                    max(once, 1e-6)));
+
+    vector<double> ns(S.repeats);
+    size_t allocs = num_allocs.load();
+    for (size_t r = 0; r < S.repeats; ++r) {
+      then = clock_type::now();
+      size_t sum = 0;
+      for (size_t i = 0; i < iterations; ++i) {
+        sum += pass();
+      }
+      double t = chrono::duration<double, nano>(clock_type::now() -
+                                                then).count();
+      if (sum != iterations * total) {
+        fprintf(stderr, "%s gave different distances on different passes\n",
+                ALGORITHMS[a].name);
+        exit(1);
+      }
+      ns[r] = t / (iterations * np);
+    }
+    allocs = num_allocs.load() - allocs;
+
+    summary s = summarize(ns);
+    printf("%s    {\"algorithm\": \"%s\", \"length\": %zu, \"ratio\": %g, "
+           "\"alphabet\": %zu, \"pairs\": %zu, \"mean_distance\": %g, "
+           "\"iterations\": %zu, \"ns_per_pair\": {\"median\": %.1f, "
+           "\"min\": %.1f, \"mean\": %.1f, \"stddev\": %.1f}, "
+           "\"cells_per_sec\": %.4g, \"allocs_per_pair\": %g}",
+           first ? "" : ",\n", ALGORITHMS[a].name, length, ratio, alphabet,
+           np, double(total) / np, iterations, s.median, s.min, s.mean,
+           s.stddev, cells / np / s.median * 1e9,
+           double(allocs) / (S.repeats * iterations * np));
+    fflush(stdout);
+  }
+
+  /// Split \a s at commas, converting each field with \a conv; exit with
+  /// status two if any can't be converted
+  template <typename T, typename F>
+  std::vector<T>
+  parse_list(const char *s, const char *what, F conv)
+  {
+    std::vector<T> out;
+    std::string text(s);
+    std::size_t i = 0;
+    for ( ; ; ) {
+      std::size_t j = text.find(',', i);
+      std::string field = text.substr(i, std::string::npos == j ?
+                                      std::string::npos : j - i);
+      T x;
+      if (!conv(field, x)) {
+        fprintf(stderr, "can't interpret `%s' as %s-- try `dl-bench "
+                "--help'\n", field.c_str(), what);
+        exit(2);
+      }
+      out.push_back(x);
+      if (std::string::npos == j) break;
+      i = j + 1;
+    }
+    return out;
+  }
+
+  bool
+  to_size(const std::string &s, std::size_t &x)
+  {
+    char *end;
+    x = strtoul(s.c_str(), &end, 10);
+    return !s.empty() && !*end;
+  }
+
+}
+
+const char * const USAGE = R"use(`%s' -- benchmark the Damerau-Levenshtein algorithms
+
+Usage: dl-bench [OPTION...]
+
+Time each algorithm on synthetic pairs of strings, over every combination
+of string length, distance ratio & alphabet size given, & write the results
+to stdout as JSON, one benchmark to a line, so that the results of two
+builds may be compared with diff or jq. The pairs are made by a port of
+admin/make-dl-test-data (see synth.hh), & are the same for any given
+parameters & seed.
+
+For each benchmark, the output gives the time per pair over the repeats
+(median, minimum, mean & standard deviation, in nanoseconds), the "cells"
+per second at the median (the product of the lengths of each pair, whether
+or not the algorithm computes that many cells of the recurrence relation),
+the mean distance (which only changes if the workload does) & the number of
+heap allocations per pair.
+
+where OPTION is one of:
+
+         -h, --help: display this usage message & exit with status zero
+      -V, --version: display this program's version & exit with status zero
+-a A, --algorithms=A: the algorithms to time, separated by commas; any of
+                     lw, uk, br & bp (the default is all four)
+-A N, --alphabets=N: the alphabet sizes, from one to 94, separated by commas
+                     (the default is 2,4,26)
+-L N, --lengths=N:   the lengths of the first string of each pair, separated
+                     by commas (the default is 4,16,64,256,1024,4096,10000)
+-m T, --min-time=T:  the least time, in milliseconds, for each repeat (the
+                     default is 20)
+-p N, --pairs=N:     the number of pairs in each workload of strings of up to
+                     256 characters; longer strings get proportionately fewer
+                     (the default is 32)
+-R R, --ratios=R:    the number of edits made to the first string of each pair
+                     to get the second, as a fraction of its length (at least
+                     one edit is always made), separated by commas (the
+                     default is 0.02,0.1,0.5)
+-r N, --repeats=N:   the number of times to time each benchmark (the default
+                     is 5)
+-s N, --seed=N:      seed the pair generator with N (the default is 1)
+)use";
+
+int
+main(int argc, char **argv)
+{
+  static struct option long_options[] = {
+    {"algorithms", required_argument, 0, 'a'},
+    {"alphabets",  required_argument, 0, 'A'},
+    {"help",       no_argument,       0, 'h'},
+    {"lengths",    required_argument, 0, 'L'},
+    {"min-time",   required_argument, 0, 'm'},
+    {"pairs",      required_argument, 0, 'p'},
+    {"ratios",     required_argument, 0, 'R'},
+    {"repeats",    required_argument, 0, 'r'},
+    {"seed",       required_argument, 0, 's'},
+    {"version",    no_argument,       0, 'V'},
+    {0, 0, 0, 0}
+  };
+
+  sweep S;
+  S.algos = { 0, 1, 2, 3 };
+  S.lengths = { 4, 16, 64, 256, 1024, 4096, 10000 };
+  S.ratios = { 0.02, 0.1, 0.5 };
+  S.alphabets = { 2, 4, 26 };
+  S.pairs = 32;
+  S.repeats = 5;
+  S.min_time_ms = 20;
+  S.seed = 1;
+
+  int c, option_index = 0;
+  while (1) {
+    c = getopt_long(argc, argv, "a:A:hL:m:p:R:r:s:V", long_options,
+                    &option_index);
+    if (-1 == c) break;
+    switch (c) {
+    case 'a':
+      S.algos = parse_list<std::size_t>(optarg, "an algorithm",
+                                        [](const std::string &s,
+                                           std::size_t &x) {
+        for (x = 0; x < sizeof(ALGORITHMS) / sizeof(ALGORITHMS[0]); ++x) {
+          if (s == ALGORITHMS[x].name) return true;
+        }
+        return false;
+      });
+      break;
+    case 'A':
+      S.alphabets = parse_list<std::size_t>(optarg, "an alphabet size",
+                                            [](const std::string &s,
+                                               std::size_t &x) {
+        return to_size(s, x) && 0 < x && x <= 94;
+      });
+      break;
+    case 'h':
+      printf(USAGE, argv[0]);
+      exit(0);
+    case 'L':
+      S.lengths = parse_list<std::size_t>(optarg, "a length", to_size);
+      break;
+    case 'm': {
+      char *end;
+      S.min_time_ms = strtod(optarg, &end);
+      if (optarg == end || *end || S.min_time_ms < 0) {
+        fprintf(stderr, "can't interpret `%s' as a time-- try `dl-bench "
+                "--help'\n", optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 'p':
+      if (!to_size(optarg, S.pairs) || 0 == S.pairs) {
+        fprintf(stderr, "can't interpret `%s' as # of pairs-- try `dl-bench "
+                "--help'\n", optarg);
+        exit(2);
+      }
+      break;
+    case 'R':
+      S.ratios = parse_list<double>(optarg, "a ratio",
+                                    [](const std::string &s, double &x) {
+        char *end;
+        x = strtod(s.c_str(), &end);
+        return !s.empty() && !*end && 0 <= x;
+      });
+      break;
+    case 'r':
+      if (!to_size(optarg, S.repeats) || 0 == S.repeats) {
+        fprintf(stderr, "can't interpret `%s' as # of repeats-- try "
+                "`dl-bench --help'\n", optarg);
+        exit(2);
+      }
+      break;
+    case 's': {
+      char *end;
+      S.seed = strtoull(optarg, &end, 10);
+      if (optarg == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as a seed-- try `dl-bench "
+                "--help'\n", optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 'V':
+      printf("`%s' %s\n", argv[0], PACKAGE_VERSION);
+      exit(0);
+    case '?':
+      /* getopt_long has already printed an error message */
+      exit(2);
+    }
+  }
+
+  if (optind != argc) {
+    fprintf(stderr, "dl-bench takes no arguments-- try `dl-bench --help'\n");
+    exit(2);
+  }
+
+  printf("{\n  \"context\": {\"program\": \"dl-bench\", \"version\": \"%s\", "
+         "\"seed\": %llu, \"pairs\": %zu, \"repeats\": %zu, "
+         "\"min_time_ms\": %g},\n  \"benchmarks\": [\n", PACKAGE_VERSION,
+         (unsigned long long) S.seed, S.pairs, S.repeats, S.min_time_ms);
+  bool first = true;
+  for (std::size_t length: S.lengths) {
+    for (double ratio: S.ratios) {
+      for (std::size_t alphabet: S.alphabets) {
+        for (std::size_t a: S.algos) {
+          run(S, a, length, ratio, alphabet, first);
+          first = false;
+        }
+      }
+    }
+  }
+  printf("\n  ]\n}\n");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "bktree.hh"
+
+#include <stdexcept>
+#include <utility>
+
+template <typename CharT>
+void
+dl::basic_bk_tree<CharT>::build()
+{
+  using namespace std;
+
+  size_t n = size();
+  if (n > numeric_limits<uint32_t>::max()) {
+    throw length_error("too many words for a BK-tree");
+  }
+  if (0 == n) {
+    return;
+  }
+
+  // Grow the tree one word at a time, keeping each node's children (as
+  // (distance, word) pairs) in a vector of their own, sorted by distance...
+  vector<vector<pair<uint32_t, uint32_t>>> children(n);
+  workspace &ws = this_thread_workspace();
+  for (uint32_t id = 1; id < n; ++id) {
+    view_type w = word(id);
+    for (uint32_t cur = 0; ; ) {
+      uint32_t d = (uint32_t)lowrance_wagner(w, word(cur), ws);
+      auto &C = children[cur];
+      auto it = lower_bound(C.begin(), C.end(), make_pair(d, uint32_t(0)));
+      if (it != C.end() && it->first == d) {
+        cur = it->second;
+      } else {
+        C.insert(it, make_pair(d, id));
+        break;
+      }
+    }
+  }
+
+  // then lay it out breadth-first, so that each node's children are adjacent.
+  vector<node> nodes;
+  nodes.reserve(n);
+  nodes.push_back(node{0, 0, 0, 0});
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto &C = children[nodes[i].id];
+    nodes[i].first = (uint32_t)nodes.size();
+    nodes[i].count = (uint32_t)C.size();
+    for (const auto &c: C) {
+      nodes.push_back(node{c.second, c.first, 0, 0});
+    }
+  }
+  nodes_.assign(move(nodes));
+}
+
+template <typename CharT>
+dl::basic_bk_tree<CharT>::basic_bk_tree(const index_file &f)
+{
+  f.expect(index_kind::bk_tree, sizeof(CharT));
+  f.section(0, text_);
+  f.section(1, offsets_);
+  f.section(2, nodes_);
+  if (offsets_.empty() || offsets_.back() != text_.size() ||
+      nodes_.size() != size()) {
+    throw std::runtime_error("malformed BK-tree");
+  }
+}
+
+template <typename CharT>
+void
+dl::basic_bk_tree<CharT>::save(const std::string &pth) const
+{
+  write_index_file(pth, index_kind::bk_tree, sizeof(CharT), {},
+                   {text_, offsets_, nodes_});
+}
+
+template class dl::basic_bk_tree<char>;
+template class dl::basic_bk_tree<char16_t>;
+template class dl::basic_bk_tree<char32_t>;
@@ -0,0 +1,231 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef BKTREE_HH_INCLUDED
+#define BKTREE_HH_INCLUDED 1
+
+#include "filter.hh"
+#include "index_file.hh"
+#include "lw.hh"
+#include "query.hh"
+#include "workspace.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /**
+   * \brief A BK-tree: an index over a dictionary of words supporting
+   * "find all words within distance k of this one"
+   *
+   *
+   * Burkhard & Keller's tree (1973) works for any metric: each node holds a
+   * word, & its children are keyed by their distance from it. If the query is
+   * d from a node, the triangle inequality says that any word within k of the
+   * query must be between d - k & d + k from that node, so only the children
+   * keyed in that range need be searched. For small k, most of the dictionary
+   * is never compared against the query at all.
+   *
+   * That argument needs a true metric, which the restricted distance computed
+   * by Ukkonen, Berghel & Roach & Hyyrö (also known as the "optimal string
+   * alignment" distance) is not: "ca" is one transposition from "ac", which is
+   * one insertion from "abc", yet "ca" is three edits from "abc" when no
+   * substring may be edited twice. An index built on it would miss matches. So
+   * the tree is built, & searched, using the unrestricted distance of
+   * Lowrance & Wagner, which is a metric; its results are exactly those a
+   * linear scan with dl::lowrance_wagner_within would produce.
+   *
+   * The tree is built once, from a range of words, & laid out breadth-first in
+   * a single array with no pointers: each node records the index of the word
+   * it holds, its distance from its parent, & the position & number of its
+   * children (which are contiguous & sorted by that distance). The words
+   * themselves are concatenated in one string. Duplicate words are kept, each
+   * a child of the other at distance zero. Since nothing in the tree is a
+   * pointer, it may be saved to disk & mapped back in (see dl::index_file).
+   *
+   * A tree is immutable once constructed & so may be shared between threads,
+   * each of which should supply its own workspace.
+   *
+   * Strings of char are compared byte by byte; use basic_bk_tree<char32_t>
+   * (u32bk_tree) to compare decoded text (see dl::utf8_decode).
+   *
+   *
+   */
+
+  template <typename CharT>
+  class basic_bk_tree
+  {
+  public:
+    typedef std::basic_string_view<CharT> view_type;
+
+  public:
+    /// Index the words in [\a p0, \a p1) (each convertible to view_type);
+    /// throws std::length_error if there are too many
+    template <typename FII>
+    basic_bk_tree(FII p0, FII p1)
+    {
+      std::vector<CharT> text;
+      std::vector<std::uint64_t> offsets(1, 0);
+      for ( ; p0 != p1; ++p0) {
+        view_type w(*p0);
+        text.insert(text.end(), w.begin(), w.end());
+        offsets.push_back(text.size());
+      }
+      text_.assign(std::move(text));
+      offsets_.assign(std::move(offsets));
+      build();
+    }
+    /// Load a tree saved to \a f, which must outlive it; throws
+    /// std::runtime_error if \a f holds some other sort of index
+    explicit basic_bk_tree(const index_file &f);
+
+  public:
+    /// Save this tree to \a pth (see dl::index_file); throws
+    /// std::system_error on failure
+    void save(const std::string &pth) const;
+
+  public:
+    /// Return the number of words in the dictionary
+    std::size_t size() const {
+      return offsets_.size() - 1;
+    }
+    /// Return the \a i-th word given at construction
+    view_type word(std::size_t i) const {
+      return view_type(text_.data() + offsets_[i],
+                       offsets_[i+1] - offsets_[i]);
+    }
+
+    /**
+     * \brief Find the words within a given distance of a query
+     *
+     *
+     * \param q [in] the query
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \param pout [in] a forward output iterator to which a dl::match shall be
+     * written for each word no more than \a max_k from \a q (in no particular
+     * order); each match's index is the word's position in the range from
+     * which the tree was built
+     *
+     * \param ws [in,out] the workspace in which to carry-out each comparison
+     *
+     * \param stats [in,out] if non-null, the cost of this search will be added
+     * to it
+     *
+     * \return \a pout, advanced past the last match written
+     *
+     *
+     * Each node's distance from the query is only needed exactly if it's no
+     * more than \a max_k past the largest key among that node's children (any
+     * further, & neither the node nor any child can qualify), so the
+     * comparisons are bounded accordingly.
+     *
+     *
+     */
+
+    template <typename FOI>
+    FOI
+    range_query(view_type q,
+                std::size_t max_k,
+                FOI pout,
+                workspace &ws,
+                search_stats *stats = nullptr) const
+    {
+      using namespace std;
+
+      auto plus = [](size_t a, size_t b) {
+        return a > numeric_limits<size_t>::max() - b ?
+          numeric_limits<size_t>::max() : a + b;
+      };
+
+      size_t evaluations = 0;
+      vector<uint32_t> todo;
+      if (!nodes_.empty()) {
+        todo.push_back(0);
+      }
+      while (!todo.empty()) {
+        const node &x = nodes_[todo.back()];
+        todo.pop_back();
+
+        size_t top = x.count ? nodes_[x.first + x.count - 1].edge : 0;
+        size_t bound = plus(top, max_k);
+        view_type a = q, b = word(x.id);
+        size_t d;
+        if (!prefilter(a, b, bound, d)) {
+          d = lowrance_wagner_within(a, b, bound, ws);
+        }
+        ++evaluations;
+        if (d <= max_k) {
+          *pout++ = match{x.id, d};
+        }
+
+        size_t lo = d > max_k ? d - max_k : 0, hi = plus(d, max_k);
+        auto c0 = nodes_.begin() + x.first, c1 = c0 + x.count;
+        auto c = lower_bound(c0, c1, lo, [](const node &y, size_t e) {
+          return y.edge < e;
+        });
+        for ( ; c != c1 && c->edge <= hi; ++c) {
+          todo.push_back(uint32_t(c - nodes_.begin()));
+        }
+      }
+
+      if (stats) {
+        ++stats->queries;
+        stats->evaluations += evaluations;
+        stats->entries += size();
+      }
+      return pout;
+    }
+
+  private:
+    void build();
+
+  private:
+    struct node {
+      /// The index of the word at this node
+      std::uint32_t id;
+      /// This word's distance from that at the parent node
+      std::uint32_t edge;
+      /// The index in nodes_ of the first child
+      std::uint32_t first;
+      /// The number of children
+      std::uint32_t count;
+    };
+
+    /// The words, end-to-end; word i is text_[offsets_[i], offsets_[i+1])
+    index_array<CharT> text_;
+    index_array<std::uint64_t> offsets_;
+    /// The tree, breadth-first; the root is nodes_[0]
+    index_array<node> nodes_;
+  };
+
+  typedef basic_bk_tree<char> bk_tree;
+  typedef basic_bk_tree<char16_t> u16bk_tree;
+  typedef basic_bk_tree<char32_t> u32bk_tree;
+
+  extern template class basic_bk_tree<char>;
+  extern template class basic_bk_tree<char16_t>;
+  extern template class basic_bk_tree<char32_t>;
+
+} // namespace dl
+
+#endif // BKTREE_HH_INCLUDED
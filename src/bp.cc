@@ -0,0 +1,237 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "bp.hh"
+#include "alphabet.hh"
+#include "bp_kernels.hh"
+
+#include <limits>
+
+using dl::detail::BP_WORD;
+
+namespace {
+
+  template <bool CountWork, typename CharT>
+  std::size_t
+  bp(std::basic_string_view<CharT> A0,
+     std::basic_string_view<CharT> B0,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    using namespace std;
+
+    // Take the shorter string as the "pattern", so as to use as few blocks as
+    // possible
+    bool swap = A0.length() > B0.length();
+    basic_string_view<CharT> A = swap ? B0 : A0;
+    basic_string_view<CharT> B = swap ? A0 : B0;
+
+    size_t m = A.length(), n = B.length();
+
+    // The kernels report the number of columns they got through, so that the
+    // cells computed may be counted
+    size_t cols = 0, *num_cols = CountWork ? &cols : nullptr;
+    auto done = [&](size_t d) {
+      if constexpr (CountWork) {
+        dl::work_stats work;
+        work.comparisons = 1;
+        work.cells = m * cols;
+        ws.add_work(work);
+      }
+      return d;
+    };
+
+    if (n - m > max_k) {
+      return done(max_k + 1);
+    }
+    if (0 == m) {
+      return done(n);
+    }
+
+    size_t nb = (m + BP_WORD - 1) / BP_WORD;
+    size_t d;
+
+    if constexpr (1 == sizeof(CharT)) {
+      // PEQ[c*nb + b] is block b of the match vector for c. Rather than clear
+      // all 256 entries, clear just those we'll look at.
+      uint64_t PEQ1[256];
+      uint64_t *PEQ = 1 == nb ? PEQ1 : ws.reserve<uint64_t>(256*nb + 4*nb);
+      for (size_t j = 0; j < n; ++j) {
+        uint64_t *p = PEQ + (unsigned char)B[j]*nb;
+        for (size_t b = 0; b < nb; ++b) p[b] = 0;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        uint64_t *p = PEQ + (unsigned char)A[i]*nb;
+        for (size_t b = 0; b < nb; ++b) p[b] = 0;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        PEQ[(unsigned char)A[i]*nb + i/BP_WORD] |= uint64_t(1) << (i % BP_WORD);
+      }
+
+      auto row = [](CharT c) { return (size_t)(unsigned char)c; };
+      if (1 == nb) {
+        d = dl::detail::hyyro_1(PEQ, m, B, max_k, row, num_cols);
+      } else {
+        d = dl::detail::hyyro_n(PEQ, m, B, max_k, row, PEQ + 256*nb, num_cols);
+      }
+    } else {
+      // There are too many wider characters to give each its own row of PEQ,
+      // so each character of A is assigned one in order of first appearance;
+      // row zero (all clear) serves for every character that doesn't appear
+      // in A. The workspace holds PEQ, then the kernel's state, then the
+      // table mapping characters to rows.
+      static_assert(sizeof(size_t) <= sizeof(uint64_t));
+      size_t nmap = dl::detail::char_map<CharT>::scratch_words(A);
+      size_t npeq = (m + 1)*nb;
+      uint64_t *PEQ = ws.reserve<uint64_t>(npeq + 4*nb + nmap);
+      dl::detail::char_map<CharT> rows(A, B, reinterpret_cast<size_t*>(PEQ + npeq + 4*nb), nmap);
+
+      for (size_t b = 0; b < nb; ++b) PEQ[b] = 0;
+      size_t num_rows = 1;
+      for (size_t i = 0; i < m; ++i) {
+        size_t r = rows.get(A[i]);
+        if (0 == r) {
+          r = num_rows++;
+          rows.set(A[i], r);
+          for (size_t b = 0; b < nb; ++b) PEQ[r*nb + b] = 0;
+        }
+        PEQ[r*nb + i/BP_WORD] |= uint64_t(1) << (i % BP_WORD);
+      }
+
+      auto row = [&rows](CharT c) { return rows.get(c); };
+      if (1 == nb) {
+        d = dl::detail::hyyro_1(PEQ, m, B, max_k, row, num_cols);
+      } else {
+        d = dl::detail::hyyro_n(PEQ, m, B, max_k, row, PEQ + npeq, num_cols);
+      }
+    }
+
+    return done(d);
+  }
+
+
+  /// Counting the work done gets an instantiation of its own, so that it
+  /// costs nothing when it's not asked for
+  template <typename CharT>
+  std::size_t
+  bp(std::basic_string_view<CharT> A,
+     std::basic_string_view<CharT> B,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    return ws.work() ? bp<true>(A, B, max_k, ws) : bp<false>(A, B, max_k, ws);
+  }
+
+}
+
+std::size_t
+dl::hyyro(std::string_view A,
+          std::string_view B)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro(std::string_view A,
+          std::string_view B,
+          workspace &ws)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::hyyro_within(std::string_view A,
+                 std::string_view B,
+                 std::size_t max_k)
+{
+  return bp(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro_within(std::string_view A,
+                 std::string_view B,
+                 std::size_t max_k,
+                 workspace &ws)
+{
+  return bp(A, B, max_k, ws);
+}
+
+std::size_t
+dl::hyyro(std::u16string_view A,
+          std::u16string_view B)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro(std::u16string_view A,
+          std::u16string_view B,
+          workspace &ws)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::hyyro_within(std::u16string_view A,
+                 std::u16string_view B,
+                 std::size_t max_k)
+{
+  return bp(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro_within(std::u16string_view A,
+                 std::u16string_view B,
+                 std::size_t max_k,
+                 workspace &ws)
+{
+  return bp(A, B, max_k, ws);
+}
+
+std::size_t
+dl::hyyro(std::u32string_view A,
+          std::u32string_view B)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro(std::u32string_view A,
+          std::u32string_view B,
+          workspace &ws)
+{
+  return bp(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::hyyro_within(std::u32string_view A,
+                 std::u32string_view B,
+                 std::size_t max_k)
+{
+  return bp(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::hyyro_within(std::u32string_view A,
+                 std::u32string_view B,
+                 std::size_t max_k,
+                 workspace &ws)
+{
+  return bp(A, B, max_k, ws);
+}
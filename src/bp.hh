@@ -0,0 +1,164 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef BP_HH_INCLUDED
+#define BP_HH_INCLUDED 1
+
+#include "workspace.hh"
+
+#include <cstddef>
+#include <string_view>
+
+namespace dl {
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the bit-parallel algorithm of Hyyrö (2002)
+   *
+   *
+   * \param A [in] the first of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \param B [in] the second of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B
+   *
+   *
+   * This function will employ the algorithm of "A Bit-Vector
+   * Algorithm for Computing Levenshtein and Damerau Edit Distances" by Heikki
+   * Hyyrö in the Nordic Journal of Computing, Vol. 10 (2003), pp 29-39.
+   *
+   * Myers (1999) observed that adjacent cells in the recurrence relation
+   * differ by at most one, & so a column of it may be represented by two
+   * bit-vectors, one marking the rows at which the column increases, and one
+   * those at which it decreases. He then showed how to compute each column
+   * from the last in a handful of bitwise & arithmetic operations on those
+   * vectors. Hyyrö extended his algorithm to account for transpositions.
+   *
+   * If the shorter of the two strings is no more than 64 characters long, a
+   * column fits in a single machine word & the algorithm runs in time O(n)
+   * (where n is the length of the longer string). Otherwise, the vectors are
+   * broken up into 64-bit blocks & the algorithm runs in time O(m*n/64).
+   *
+   * Like Ukkonen's algorithm & that of Berghel & Roach, this computes the
+   * "restricted" Damerau-Levenshtein distance (in which no substring may be
+   * edited more than once).
+   *
+   *
+   */
+
+  std::size_t
+  hyyro(std::string_view A,
+        std::string_view B);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B using the
+  /// algorithm of Hyyrö (2002) in the workspace \a ws
+  std::size_t
+  hyyro(std::string_view A,
+        std::string_view B,
+        workspace &ws);
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the algorithm of Hyyrö (2002), giving up once it is known to exceed a
+   * given threshold
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B if that is
+   * less than or equal to \a max_k, or \a max_k + 1 otherwise
+   *
+   *
+   * The algorithm tracks the value in the last row of the current column, &
+   * that can fall by at most one per column remaining, so we stop once it
+   * exceeds \a max_k by more than the number of columns left.
+   *
+   *
+   */
+
+  std::size_t
+  hyyro_within(std::string_view A,
+               std::string_view B,
+               std::size_t max_k);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B, up to
+  /// \a max_k, using the algorithm of Hyyrö (2002) in the workspace \a ws
+  std::size_t
+  hyyro_within(std::string_view A,
+               std::string_view B,
+               std::size_t max_k,
+               workspace &ws);
+
+  /// As above, for strings of 16-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  hyyro(std::u16string_view A,
+        std::u16string_view B);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::size_t
+  hyyro(std::u16string_view A,
+        std::u16string_view B,
+        workspace &ws);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k
+  std::size_t
+  hyyro_within(std::u16string_view A,
+               std::u16string_view B,
+               std::size_t max_k);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  hyyro_within(std::u16string_view A,
+               std::u16string_view B,
+               std::size_t max_k,
+               workspace &ws);
+
+  /// As above, for strings of 32-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  hyyro(std::u32string_view A,
+        std::u32string_view B);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::size_t
+  hyyro(std::u32string_view A,
+        std::u32string_view B,
+        workspace &ws);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k
+  std::size_t
+  hyyro_within(std::u32string_view A,
+               std::u32string_view B,
+               std::size_t max_k);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  hyyro_within(std::u32string_view A,
+               std::u32string_view B,
+               std::size_t max_k,
+               workspace &ws);
+
+} // namespace dl
+
+#endif // BP_HH_INCLUDED
@@ -0,0 +1,238 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef BP_KERNELS_HH_INCLUDED
+#define BP_KERNELS_HH_INCLUDED 1
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * \file bp_kernels.hh
+ *
+ * \brief The inner loops of Hyyrö's algorithm, shared by dl::hyyro &
+ * dl::query
+ *
+ *
+ * Both kernels take the "pattern" string in pre-processed form: a table of
+ * match vectors PEQ, with PEQ[r*nb + b] holding block b of the vector whose
+ * bit i is set iff the i-th character of the pattern is the character
+ * assigned to row r (where nb is the number of 64-bit blocks needed to hold
+ * the pattern). Each kernel is handed a function object mapping characters
+ * to rows: for strings of char, that's just the character itself, taken as
+ * unsigned; wider characters are looked up in a dl::detail::char_map. Rows
+ * for characters appearing in \a B must be initialized; others are never
+ * read.
+ *
+ *
+ */
+
+namespace dl {
+
+  namespace detail {
+
+    /// The number of bits in a block
+    const std::size_t BP_WORD = 64;
+
+    /**
+     * \brief Hyyrö's algorithm where the pattern fits in a single word
+     *
+     *
+     * \param PEQ [in] match vectors for a pattern of length \a m
+     *
+     * \param m [in] the length of the pattern
+     *
+     * \param B [in] the string to be compared to the pattern
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \param row [in] a function object mapping each character of \a B to
+     * its row of \a PEQ
+     *
+     * \param columns [out] if non-null, the number of columns (characters of
+     * \a B) processed before the kernel finished or gave up
+     *
+     * \return the distance between the pattern & \a B if that is less than or
+     * equal to \a max_k, or \a max_k + 1 otherwise
+     *
+     * \pre 0 < \a m <= 64
+     *
+     *
+     */
+
+    template <typename CharT, typename RowOf>
+    std::size_t
+    hyyro_1(const std::uint64_t *PEQ,
+            std::size_t m,
+            std::basic_string_view<CharT> B,
+            std::size_t max_k,
+            RowOf row,
+            std::size_t *columns = nullptr)
+    {
+      using namespace std;
+
+      size_t n = B.length();
+
+      // VP & VN mark the rows at which the current column increases &
+      // decreases (resp.) from the row before; D0 marks the rows at which the
+      // diagonal does *not* increase. `score' is the value in the last row.
+      uint64_t VP = ~uint64_t(0), VN = 0, D0 = 0, PM_prev = 0;
+      uint64_t top = uint64_t(1) << (m - 1);
+      size_t score = m;
+
+      for (size_t j = 0; j < n; ++j) {
+        uint64_t PM = PEQ[row(B[j])];
+        // A transposition is possible at row i iff A[i] = B[j-1], A[i-1] = B[j]
+        // & the diagonal increased at (i-1,j-1)
+        uint64_t TR = (((~D0) & PM) << 1) & PM_prev;
+        D0 = (((PM & VP) + VP) ^ VP) | PM | VN | TR;
+        uint64_t HP = VN | ~(D0 | VP);
+        uint64_t HN = D0 & VP;
+        if (HP & top) {
+          ++score;
+        } else if (HN & top) {
+          --score;
+        }
+        // The last row can fall by at most one in each remaining column
+        if (score > max_k && score - max_k > n - j - 1) {
+          if (columns) *columns = j + 1;
+          return max_k + 1;
+        }
+        HP = (HP << 1) | 1;
+        HN = HN << 1;
+        VP = HN | ~(D0 | HP);
+        VN = D0 & HP;
+        PM_prev = PM;
+      }
+
+      if (columns) *columns = n;
+      return score > max_k ? max_k + 1 : score;
+    }
+
+    /**
+     * \brief Hyyrö's algorithm on bit-vectors of any length
+     *
+     *
+     * \param PEQ [in] match vectors for a pattern of length \a m
+     *
+     * \param m [in] the length of the pattern
+     *
+     * \param B [in] the string to be compared to the pattern
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \param row [in] a function object mapping each character of \a B to
+     * its row of \a PEQ
+     *
+     * \param state [out] room for 4*nb words, in which the kernel keeps its
+     * bit-vectors
+     *
+     * \param columns [out] if non-null, the number of columns (characters of
+     * \a B) processed before the kernel finished or gave up
+     *
+     * \return the distance between the pattern & \a B if that is less than or
+     * equal to \a max_k, or \a max_k + 1 otherwise
+     *
+     * \pre 0 < \a m
+     *
+     *
+     * This is the same computation as hyyro_1, carried out on bit-vectors
+     * spanning several words. Each operation in the single-word version is
+     * either bitwise, a left shift or an addition, so the blocks may be
+     * processed from least- to most-significant, carrying the bit shifted out
+     * of (or the carry out of the addition in) each into the next.
+     *
+     *
+     */
+
+    template <typename CharT, typename RowOf>
+    std::size_t
+    hyyro_n(const std::uint64_t *PEQ,
+            std::size_t m,
+            std::basic_string_view<CharT> B,
+            std::size_t max_k,
+            RowOf row,
+            std::uint64_t *state,
+            std::size_t *columns = nullptr)
+    {
+      using namespace std;
+
+      const size_t W = BP_WORD;
+
+      size_t n = B.length();
+      size_t nb = (m + W - 1) / W;
+
+      uint64_t *VP = state, *VN = VP + nb, *D0 = VN + nb, *PM_prev = D0 + nb;
+      for (size_t b = 0; b < nb; ++b) {
+        VP[b] = ~uint64_t(0);
+        VN[b] = D0[b] = PM_prev[b] = 0;
+      }
+
+      size_t last = nb - 1;
+      uint64_t top = uint64_t(1) << ((m - 1) % W);
+      size_t score = m;
+
+      for (size_t j = 0; j < n; ++j) {
+        const uint64_t *PM = PEQ + row(B[j])*nb;
+        // Carries into the next block: for the shift in computing TR, for the
+        // addition, and for the shifts of HP & HN (the first row of the
+        // recurrence relation increases by one in each column, so that shifts
+        // in a one)
+        uint64_t c_tr = 0, c_add = 0, c_hp = 1, c_hn = 0;
+        for (size_t b = 0; b < nb; ++b) {
+          uint64_t pm = PM[b], vp = VP[b], vn = VN[b];
+          uint64_t x = (~D0[b]) & pm;
+          uint64_t TR = ((x << 1) | c_tr) & PM_prev[b];
+          c_tr = x >> (W - 1);
+          uint64_t X = pm & vp;
+          uint64_t sum = X + vp;
+          uint64_t c = sum < X;
+          sum += c_add;
+          c_add = c | (sum < c_add);
+          uint64_t d0 = (sum ^ vp) | pm | vn | TR;
+          uint64_t HP = vn | ~(d0 | vp);
+          uint64_t HN = d0 & vp;
+          if (b == last) {
+            if (HP & top) {
+              ++score;
+            } else if (HN & top) {
+              --score;
+            }
+          }
+          uint64_t hp = (HP << 1) | c_hp;
+          c_hp = HP >> (W - 1);
+          uint64_t hn = (HN << 1) | c_hn;
+          c_hn = HN >> (W - 1);
+          VP[b] = hn | ~(d0 | hp);
+          VN[b] = d0 & hp;
+          D0[b] = d0;
+          PM_prev[b] = pm;
+        }
+        if (score > max_k && score - max_k > n - j - 1) {
+          if (columns) *columns = j + 1;
+          return max_k + 1;
+        }
+      }
+
+      if (columns) *columns = n;
+      return score > max_k ? max_k + 1 : score;
+    }
+
+  } // namespace detail
+
+} // namespace dl
+
+#endif // BP_KERNELS_HH_INCLUDED
@@ -13,29 +13,40 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see https://www.gnu.org/licenses/.
 
+#include "config.h"
 #include "br.hh"
 
-#include <cassert>
-#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
 
 namespace {
 
+  /// The cell of FKP holding f(\a k, \a p); each diagonal has two, holding
+  /// its two most recent values (see br, below)
+  inline ptrdiff_t&
+  cell(ptrdiff_t *fkp, ptrdiff_t k, ptrdiff_t p)
+  {
+    return fkp[2*k + (p & 1)];
+  }
+
+  /// Compute f(\a k, \a p) (if \a CountWork, adding the number of matching
+  /// characters slid over to \a slides)
+  template <bool CountWork, typename CharT>
   ptrdiff_t
   f(ptrdiff_t k,
     ptrdiff_t p,
-    const std::string &A,
-    const std::string &B,
+    std::basic_string_view<CharT> A,
+    std::basic_string_view<CharT> B,
     size_t m,
     size_t n,
-    size_t max_k,
-    size_t max_p,
     std::ptrdiff_t *fkp,
-    ptrdiff_t zero_k,
-    size_t inf) {
+    size_t inf,
+    std::size_t &slides) {
 
     ptrdiff_t t = -inf;
     if (p >= 0) {
-      t = fkp[(k + zero_k)*max_p+p] + 1;
+      t = cell(fkp, k, p - 1) + 1;
     }
     ptrdiff_t t2 = t;
     if (t > 0 && t < m && k+t-1 >= 0 && k + t < n) {
@@ -49,82 +60,245 @@ namespace {
     }
     ptrdiff_t ta = -inf;
     if (p >= 0) {
-      ta = fkp[(k - 1 + zero_k)*max_p+p];
+      ta = cell(fkp, k - 1, p - 1);
     }
     ptrdiff_t tb = -inf;
     if (p >= 0) {
-      tb = fkp[(k + 1 + zero_k)*max_p+p] + 1;
+      tb = cell(fkp, k + 1, p - 1) + 1;
     }
     if (ta > t) t = ta;
     if (tb > t) t = tb;
     if (t2 > t) t = t2;
     ptrdiff_t L = (ptrdiff_t)std::min(m, n - k);
+    ptrdiff_t t0 = t;
     while (t >= 0 && t >= -k && t < L && A[t] == B[t+k]) ++t;
-    if (k + zero_k >= 0 && p > -2) {
-      fkp[(k + zero_k)*max_p+p+1] = t;
-    }
+    if constexpr (CountWork) slides += t - t0;
+    cell(fkp, k, p) = t;
     return t;
   }
 
-}
+  /// Initialize the boundary cells of diagonal \a k: f(k,|k|-1) & f(k,|k|-2)
+  inline void
+  init_diagonal(ptrdiff_t *fkp, ptrdiff_t k, size_t inf)
+  {
+    ptrdiff_t abs_k = k < 0 ? -k : k;
+    cell(fkp, k, abs_k - 1) = k < 0 ? abs_k - 1 : -1;
+    cell(fkp, k, abs_k - 2) = -inf;
+  }
 
-bool
-berghel_roach(const std::string &A,
-              const std::string &B,
-              size_t max_k,
-              size_t max_p,
-              std::ptrdiff_t *fkp,
-              ptrdiff_t zero_k,
-              size_t inf,
-              std::size_t D,
-              bool verb)
-{
-  using namespace std;
-
-  size_t m = A.length();
-  size_t n = B.length();
-  // If this assertion fires, the caller has violated our precondition that
-  // `A` be less than or equal to `B` in length.
-  assert(m <= n);
-  // The minmal p will be at the end of diagonal k
-  ptrdiff_t k = n - m;
-  ptrdiff_t p = k;
-
-  if (verb) {
-    cout << "Comparing '" << A << "' (" << m << ") to '" << B <<
-      "' (" << n << ") starting k at " << k << endl;
-    cout << "FKP:\n";
-    for (size_t k = 0; k < max_k; ++k) {
-      for (size_t p = 0; p < max_p; ++p) {
-        if (p != 0) cout << ", ";
-        cout << fkp[k*max_p+p];
+  template <bool CountWork, typename CharT>
+  std::size_t
+  br(std::basic_string_view<CharT> A0,
+     std::basic_string_view<CharT> B0,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    using namespace std;
+
+    // The algorithm assumes that `A` is less than or equal to `B` in length.
+    bool swap = A0.length() > B0.length();
+    basic_string_view<CharT> A = swap ? B0 : A0;
+    basic_string_view<CharT> B = swap ? A0 : B0;
+
+    size_t m = A.length();
+    size_t n = B.length();
+
+    // The work done is tallied in locals & only handed to the workspace on
+    // the way out
+    size_t diagonals = 0, slides = 0;
+    auto done = [&](size_t d) {
+      if constexpr (CountWork) {
+        dl::work_stats work;
+        work.comparisons = 1;
+        work.diagonals = diagonals;
+        work.slides = slides;
+        ws.add_work(work);
       }
-      cout << endl;
+      return d;
+    };
+
+    // The distance is at least the difference in lengths...
+    if (n - m > max_k) {
+      return done(max_k + 1);
     }
-  }
+    // Handle the empty string up-front, lest we look at diagonal n + 1 below
+    if (0 == m) {
+      return done(n);
+    }
+
+    size_t inf = n;
+    ptrdiff_t c = n - m;
+
+    // In the exposition, FKP is a two-dimensional array indexed by every
+    // diagonal (-m to n) & every p (-1 to max(m,n)). Two observations shrink
+    // it considerably:
+    //
+    // 1. the round of the loop below in which p = P computes f(k,p') only
+    //    for |k - c| <= P (where c = n - m, the final diagonal), & reads only
+    //    diagonals one further out than that; since P never exceeds the
+    //    distance (nor max_k), neither does the band of diagonals touched
+    //
+    // 2. f(k,p) reads only f(k-1,p-1), f(k,p-1) & f(k+1,p-1), & the rounds
+    //    are ordered such that by the time f(k,p) is written, nothing will
+    //    read f(k,p-2) again
+    //
+    // So FKP need only hold two cells per diagonal (indexed by the parity of
+    // p) over the diagonals c - W to c + W, where W is one more than the
+    // bound on the distance. Each diagonal's cells are adjacent, & the band
+    // grows outward from c one diagonal in each direction per round; only
+    // the diagonals the band has reached are ever initialized (or touched).
+    ptrdiff_t W = (ptrdiff_t)min(max_k, n) + 1;
+    ptrdiff_t *fkp = ws.reserve<ptrdiff_t>(2*(2*W + 1)) + 2*(W - c);
 
-  do {
-    ptrdiff_t inc = p;
-    for (ptrdiff_t temp_p = 0; temp_p < p; ++temp_p) {
-      ptrdiff_t x = n - m - inc;
-      if (abs(x) <= temp_p) {
-        f(x, temp_p, A, B, m, n, max_k, max_p, fkp, zero_k, inf);
+    // The minmal p will be at the end of diagonal k
+    ptrdiff_t k = c;
+    ptrdiff_t p = k;
+
+    for (ptrdiff_t x = c - p - 1; x <= c + p + 1; ++x) {
+      init_diagonal(fkp, x, inf);
+    }
+
+    do {
+      // Every iteration from here on can only establish a distance of p or
+      // more.
+      if ((size_t)p > max_k) {
+        return done(max_k + 1);
       }
-      x = n - m + inc;
-      if (abs(x) <= temp_p) {
-        f(x, temp_p, A, B, m, n, max_k, max_p, fkp, zero_k, inf);
+      if (p > c) {
+        init_diagonal(fkp, c - p - 1, inf);
+        init_diagonal(fkp, c + p + 1, inf);
       }
-      --inc;
-    }
-    f(n - m, p, A, B, m, n, max_k, max_p, fkp, zero_k, inf);
-    ++p;
-    } while (fkp[(n - m + zero_k)*max_p+p] != m);
+      ptrdiff_t inc = p;
+      for (ptrdiff_t temp_p = 0; temp_p < p; ++temp_p) {
+        ptrdiff_t x = c - inc;
+        if (abs(x) <= temp_p) {
+          f<CountWork>(x, temp_p, A, B, m, n, fkp, inf, slides);
+          ++diagonals;
+        }
+        x = c + inc;
+        if (abs(x) <= temp_p) {
+          f<CountWork>(x, temp_p, A, B, m, n, fkp, inf, slides);
+          ++diagonals;
+        }
+        --inc;
+      }
+      f<CountWork>(c, p, A, B, m, n, fkp, inf, slides);
+      ++diagonals;
+      ++p;
+    } while (cell(fkp, c, p - 1) != (ptrdiff_t)m);
 
-  size_t s = p - 1;
+    return done(p - 1);
+  }
 
-  if (verb) {
-    cout << "Computed distance: " << s << endl;
+  /// Counting the work done costs several percent on short strings, so it's
+  /// compiled into an instantiation of its own, used only when asked for
+  template <typename CharT>
+  std::size_t
+  br(std::basic_string_view<CharT> A,
+     std::basic_string_view<CharT> B,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    return ws.work() ? br<true>(A, B, max_k, ws) : br<false>(A, B, max_k, ws);
   }
-  return s == D;
 
 }
+
+std::size_t
+dl::berghel_roach(std::string_view A,
+                  std::string_view B)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach(std::string_view A,
+                  std::string_view B,
+                  workspace &ws)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::berghel_roach_within(std::string_view A,
+                         std::string_view B,
+                         std::size_t max_k)
+{
+  return br(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach_within(std::string_view A,
+                         std::string_view B,
+                         std::size_t max_k,
+                         workspace &ws)
+{
+  return br(A, B, max_k, ws);
+}
+
+std::size_t
+dl::berghel_roach(std::u16string_view A,
+                  std::u16string_view B)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach(std::u16string_view A,
+                  std::u16string_view B,
+                  workspace &ws)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::berghel_roach_within(std::u16string_view A,
+                         std::u16string_view B,
+                         std::size_t max_k)
+{
+  return br(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach_within(std::u16string_view A,
+                         std::u16string_view B,
+                         std::size_t max_k,
+                         workspace &ws)
+{
+  return br(A, B, max_k, ws);
+}
+
+std::size_t
+dl::berghel_roach(std::u32string_view A,
+                  std::u32string_view B)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach(std::u32string_view A,
+                  std::u32string_view B,
+                  workspace &ws)
+{
+  return br(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::berghel_roach_within(std::u32string_view A,
+                         std::u32string_view B,
+                         std::size_t max_k)
+{
+  return br(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::berghel_roach_within(std::u32string_view A,
+                         std::u32string_view B,
+                         std::size_t max_k,
+                         workspace &ws)
+{
+  return br(A, B, max_k, ws);
+}
@@ -16,152 +16,169 @@
 #ifndef BR_HH_INCLUDED
 #define BR_HH_INCLUDED 1
 
-#include <config.h>
+#include "workspace.hh"
+
 #include <cstddef>
-#include <algorithm>
-#include <string>
-#include <tuple>
-#include <vector>
-
-/**
- * \brief Compute the Damerau-Levenshtein distance between two strings using
- * the algorithm of Berghel & Roach (1996)
- *
- *
- * \param A [in] the first of the two strings whose Damerau-Levenshtein distance
- * is to be computed
- *
- * \param B [in] the second of the two strings whose Damerau-Levenshtein
- * distance is to be computed
- *
- * \pre \a A shall be less than or equal to \a B in length
- *
- * \param D [in] the known Damerau-Levenshtein distance between \a A & \a B
- *
- * \param verb [in] if true, produce verbose progress messages on \c stdout
- *
- * \return true if the edit distance is computed to be D, false else
- *
- *
- * This function will employ Algorithm "BR" as defined in section 3 of "An
- * Extension of Ukknonen's Enhanced Dynamic Programming ASM Algorithm" by Hal
- * Berghel and David Roach the the ACM Transactions on Information Systems,
- * Vol. 14 No. 1 January 1996, pp94-106.
- *
- * Berghel's & Roach's improvement is a tighter bound on the range of f(k,p)
- * that need to be computed for any given comparison. If s is the edit
- * distance from \a A to \a B, and m & n their resp. string lenghts, and
- * WLOG n >= m, define p:
- *
- \code
-
-    1       1
-   --- - -------
-   2*s   2*(n-m)
-
- \endcode
- *
- * The worst-case running time of this algorithms is O(n*p) and the expected
- * running time is O(n+(p*s)).
- *
- * After reading this paper, I spent some time searching the literature for
- * references to it (looking for further improvements). I didn't find any
- * directly-related improvements. Later references either cited it as the
- * best known to the author(s)' for computing Damerau-Levenshtein distance,
- * or as a point of interest in developing string metrics.
- *
- *
- */
-
-bool
-berghel_roach(const std::string &A,
-              const std::string &B,
-              size_t max_k,
-              size_t max_p,
-              std::ptrdiff_t *fkp,
-              ptrdiff_t zero_k,
-              size_t inf,
-              std::size_t D,
-              bool verb);
-
-/**
- * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
- * using the algorithm of Berghel & Roach (1996)
- *
- *
- * \param p0 [in] A forward input iterator referencing the beginning of a range
- * of test cases (on which more below)
- *
- * \param p1 [in] A forward input iterator referencing the one-past-the-end
- * position of a range of test cases
- *
- * \param inf [in] Maximum length across all strings in the test corpus; unused
- * in this case, it is provided in case a given algorithm can optimize over all
- * comparisons
- *
- * \param verb [in] If true, produce verbose status messages on \c stdout
- *
- * \return true if this implementation calculated the known D-L edit distance
- * for each case in [p0, p1), false else
- *
- *
- * A "test case" is simply a three-tuple: string "A", string "B", and the known
- * distance between them. IOW, type \a FII shall dereference to
- * std::tuple(std::string, std::string, std::size_t). I arrange for all D-L
- * algorithms in this program to take a range of test cases (instead of a single
- * test case) to enable them to take advantage any one-time initialization logic
- * or other global optimizations which they may provide.
- *
- *
- */
-
-template <typename FII>
-bool
-test_berghel_roach(FII p0,
-                   FII p1,
-                   size_t inf,
-                   bool verb)
-{
-  using namespace std;
-
-  // We can build FKP here & re-use it for each individual comparison. FKP is a
-  // two- dimensional array consisting of `max_k' rows & `max_p' columns. In the
-  // exposition, the indicies run over -m to n (all diagonals) and from -1 to
-  // the maxium p (max(m,n) = `inf') respectivey.
-  size_t max_k = inf + inf + 1;
-  size_t max_p = inf + 2;
-  // That means that to lookup the value for f(k,p), we need to index as:
-  // FKP[k + zero_k][p+1] (i.e. the exposition is incorrect in this regard).
-  ptrdiff_t zero_k = inf;
-
-  // ptrdiff_t FKP[max_k][max_p];
-  ptrdiff_t FKP[max_k*max_p];
-  for (ptrdiff_t i = 0; i < max_k; ++i) {
-    for (ptrdiff_t j = 0; j < max_p; ++j) {
-      FKP[i*max_p+j] = -inf;
-    }
-  }
-  for (ptrdiff_t k = - zero_k; k <= zero_k; ++k) {
-    ptrdiff_t abs_k = k;
-    if (k < 0) abs_k = -k;
-    for (ptrdiff_t p = -1; p <= (ptrdiff_t)inf; ++p) {
-      if (p == abs_k - 1) {
-        if (k < 0) {
-          FKP[(k + zero_k)*max_p + p+1] = abs_k - 1;
-        } else {
-          FKP[(k + zero_k)*max_p + p+1] = -1;
-        }
-      }
-    }
-  }
-
-  return all_of(p0,
-                p1,
-                [&](const tuple<string, string, size_t> &tc) {
-                  string A, B;
-                  size_t d;
-                  tie(A, B, d) = tc;
-                  return berghel_roach(A, B, max_k, max_p, (ptrdiff_t*)FKP, zero_k, inf, d, verb);
-                });
-}
+#include <string_view>
+
+namespace dl {
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the algorithm of Berghel & Roach (1996)
+   *
+   *
+   * \param A [in] the first of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \param B [in] the second of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B
+   *
+   *
+   * This function will employ Algorithm "BR" as defined in section 3 of "An
+   * Extension of Ukknonen's Enhanced Dynamic Programming ASM Algorithm" by Hal
+   * Berghel and David Roach the the ACM Transactions on Information Systems,
+   * Vol. 14 No. 1 January 1996, pp94-106.
+   *
+   * Berghel's & Roach's improvement is a tighter bound on the range of f(k,p)
+   * that need to be computed for any given comparison. If s is the edit
+   * distance from \a A to \a B, and m & n their resp. string lenghts, and
+   * WLOG n >= m, define p:
+   *
+   \code
+
+      1       1
+     --- - -------
+     2*s   2*(n-m)
+
+   \endcode
+   *
+   * The worst-case running time of this algorithms is O(n*p) and the expected
+   * running time is O(n+(p*s)).
+   *
+   * The paper assumes that \a A is no longer than \a B; this implementation
+   * will swap them if that is not the case.
+   *
+   * FKP is taken from the calling thread's workspace (see
+   * this_thread_workspace). Only two cells per diagonal are kept (f(k,p) &
+   * f(k,p-1)), & only for the band of diagonals the current p can reach, so
+   * that its size depends on the distance being computed (or the bound
+   * given to berghel_roach_within) rather than on the product of the
+   * strings' lengths: room is reserved for O(min(n, max_k)) cells, of which
+   * only O(s) are touched, as the band grows.
+   *
+   * After reading this paper, I spent some time searching the literature for
+   * references to it (looking for further improvements). I didn't find any
+   * directly-related improvements. Later references either cited it as the
+   * best known to the author(s)' for computing Damerau-Levenshtein distance,
+   * or as a point of interest in developing string metrics.
+   *
+   *
+   */
+
+  std::size_t
+  berghel_roach(std::string_view A,
+                std::string_view B);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B using the
+  /// algorithm of Berghel & Roach (1996) in the workspace \a ws
+  std::size_t
+  berghel_roach(std::string_view A,
+                std::string_view B,
+                workspace &ws);
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the algorithm of Berghel & Roach (1996), giving up once it is known to
+   * exceed a given threshold
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B if that is
+   * less than or equal to \a max_k, or \a max_k + 1 otherwise
+   *
+   *
+   * Like Ukkonen's, this algorithm evaluates f(k,p) for increasing p until
+   * f(n-m,p) = m; we simply stop once p exceeds \a max_k. Since p starts at
+   * n - m, pairs whose lengths differ by more than \a max_k are rejected
+   * without examining a single character.
+   *
+   *
+   */
+
+  std::size_t
+  berghel_roach_within(std::string_view A,
+                       std::string_view B,
+                       std::size_t max_k);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B, up to
+  /// \a max_k, using the algorithm of Berghel & Roach (1996) in the
+  /// workspace \a ws
+  std::size_t
+  berghel_roach_within(std::string_view A,
+                       std::string_view B,
+                       std::size_t max_k,
+                       workspace &ws);
+
+  /// As above, for strings of 16-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  berghel_roach(std::u16string_view A,
+                std::u16string_view B);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::size_t
+  berghel_roach(std::u16string_view A,
+                std::u16string_view B,
+                workspace &ws);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k
+  std::size_t
+  berghel_roach_within(std::u16string_view A,
+                       std::u16string_view B,
+                       std::size_t max_k);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  berghel_roach_within(std::u16string_view A,
+                       std::u16string_view B,
+                       std::size_t max_k,
+                       workspace &ws);
+
+  /// As above, for strings of 32-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  berghel_roach(std::u32string_view A,
+                std::u32string_view B);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::size_t
+  berghel_roach(std::u32string_view A,
+                std::u32string_view B,
+                workspace &ws);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k
+  std::size_t
+  berghel_roach_within(std::u32string_view A,
+                       std::u32string_view B,
+                       std::size_t max_k);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  berghel_roach_within(std::u32string_view A,
+                       std::u32string_view B,
+                       std::size_t max_k,
+                       workspace &ws);
+
+} // namespace dl
+
 #endif // BR_HH_INCLUDED
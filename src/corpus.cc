@@ -0,0 +1,201 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "corpus.hh"
+
+#include <cerrno>
+#include <system_error>
+#include <tuple>
+
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+namespace {
+
+  std::system_error
+  make_error(const char *what, const std::filesystem::path &pth)
+  {
+    std::stringstream stm;
+    stm << what << " `" << pth.string() << "'";
+    return std::system_error(errno, std::generic_category(), stm.str());
+  }
+
+}
+
+corpus_file::corpus_file(const std::filesystem::path &pth):
+  pth_(pth), p_(nullptr), n_(0), mapped_(false)
+{
+  int fd = open(pth.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    throw make_error("failed to open", pth);
+  }
+
+# if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  // Regular files are mapped...
+  struct stat st;
+  if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && 0 < st.st_size) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED != p) {
+      p_ = (const char*)p;
+      n_ = st.st_size;
+      mapped_ = true;
+      close(fd);
+      return;
+    }
+  }
+# endif
+
+  // while anything else (a pipe, say) is read into a buffer.
+  const std::size_t CHUNK = 1 << 16;
+  for (std::size_t n = 0; ; ) {
+    buf_.resize(n + CHUNK);
+    ssize_t nread = read(fd, buf_.data() + n, CHUNK);
+    if (-1 == nread) {
+      if (EINTR == errno) continue;
+      std::system_error err = make_error("failed to read", pth);
+      close(fd);
+      throw err;
+    }
+    n += nread;
+    if (0 == nread) {
+      buf_.resize(n);
+      break;
+    }
+  }
+  close(fd);
+  p_ = buf_.data();
+  n_ = buf_.size();
+}
+
+corpus_file::corpus_file(corpus_file &&that) noexcept:
+  pth_(std::move(that.pth_)),
+  p_(that.p_),
+  n_(that.n_),
+  mapped_(that.mapped_),
+  buf_(std::move(that.buf_))
+{
+  that.p_ = nullptr;
+  that.n_ = 0;
+  that.mapped_ = false;
+}
+
+corpus_file::~corpus_file()
+{
+  release();
+}
+
+corpus_file&
+corpus_file::operator=(corpus_file &&that) noexcept
+{
+  if (this != &that) {
+    release();
+    pth_ = std::move(that.pth_);
+    p_ = that.p_;
+    n_ = that.n_;
+    mapped_ = that.mapped_;
+    buf_ = std::move(that.buf_);
+    that.p_ = nullptr;
+    that.n_ = 0;
+    that.mapped_ = false;
+  }
+  return *this;
+}
+
+void
+corpus_file::release()
+{
+# if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  if (mapped_) {
+    munmap((void*)p_, n_);
+  }
+# endif
+  p_ = nullptr;
+  n_ = 0;
+  mapped_ = false;
+}
+
+dl::cost_table
+read_costs(const corpus_file &f)
+{
+  using namespace std;
+
+  // The defaults must be known before the table is built, so the pairs are
+  // set once every line has been read.
+  double ins = 1, del = 1, sub = 1, tra = 1;
+  vector<tuple<bool, char, char, double>> pairs;
+
+  string_view text = f.contents();
+  const char *p = text.data(), *pend = p + text.size();
+  for (size_t lineno = 1; p < pend; ++lineno) {
+    const char *eol = (const char*)memchr(p, '\n', pend - p);
+    if (!eol) eol = pend;
+    string line(p, eol - p);
+    p = eol + 1;
+
+    if (line.empty() || line[0] == '#') continue;
+    istringstream stm(line);
+    vector<string> fields;
+    for (string x; stm >> x; ) fields.push_back(x);
+    if (fields.empty()) continue;
+    const string &kind = fields[0];
+    double cost;
+    bool is_sub = "substitution" == kind, is_tra = "transposition" == kind;
+    bool ok = false;
+    if (2 == fields.size()) {
+      istringstream c(fields[1]);
+      ok = (c >> cost) && c.eof() && 0 <= cost;
+      if (ok) {
+        if ("insertion" == kind) ins = cost;
+        else if ("deletion" == kind) del = cost;
+        else if (is_sub) sub = cost;
+        else if (is_tra) tra = cost;
+        else ok = false;
+      }
+    } else if (4 == fields.size() && (is_sub || is_tra) &&
+               1 == fields[1].size() && 1 == fields[2].size()) {
+      istringstream c(fields[3]);
+      ok = (c >> cost) && c.eof() && 0 <= cost;
+      if (ok) {
+        pairs.emplace_back(is_sub, fields[1][0], fields[2][0], cost);
+      }
+    }
+    if (!ok) {
+      stringstream err;
+      err << "parse error in `" << f.path() << "', line " << lineno;
+      throw runtime_error(err.str());
+    }
+  }
+
+  dl::cost_table costs(ins, del, sub, tra);
+  for (const auto &x: pairs) {
+    if (get<0>(x)) {
+      costs.set_substitution(get<1>(x), get<2>(x), get<3>(x));
+    } else {
+      costs.set_transposition(get<1>(x), get<2>(x), get<3>(x));
+    }
+  }
+  return costs;
+}
@@ -0,0 +1,238 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef CORPUS_HH_INCLUDED
+#define CORPUS_HH_INCLUDED 1
+
+#include "harness.hh"
+
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+/**
+ * \brief A corpus file, mapped into memory
+ *
+ *
+ * For large corpora, reading the file line-by-line & copying each field into
+ * its own std::string dominates the time taken to run the driver. Instead,
+ * the entire file is mapped into our address space (where mmap is available &
+ * the file is a regular file; otherwise, it is read into a single buffer) &
+ * the test cases are views into that.
+ *
+ *
+ */
+
+class corpus_file
+{
+public:
+  /// Map the file at \a pth; throws std::system_error on failure
+  explicit corpus_file(const std::filesystem::path &pth);
+  corpus_file(const corpus_file &) = delete;
+  corpus_file(corpus_file &&that) noexcept;
+  ~corpus_file();
+  corpus_file& operator=(const corpus_file &) = delete;
+  corpus_file& operator=(corpus_file &&that) noexcept;
+
+public:
+  /// Return the path from which this corpus was read
+  const std::filesystem::path& path() const {
+    return pth_;
+  }
+  /// Return the contents of the file; the view remains valid for the lifetime
+  /// of this object (including across moves)
+  std::string_view contents() const {
+    return std::string_view(p_, n_);
+  }
+
+private:
+  void release();
+
+private:
+  std::filesystem::path pth_;
+  const char *p_;
+  std::size_t n_;
+  /// True if p_ was obtained from mmap, false if it points into buf_
+  bool mapped_;
+  std::vector<char> buf_;
+};
+
+/**
+ * \brief Read a collection of test cases from file
+ *
+ *
+ * \param f [in] a text file containing one or more test cases (see
+ * below for expected format)
+ *
+ * \param pout [in,out] A forward output iterator two which each test case read
+ * from \a f shall be copied; the strings in each are views into \a f
+ *
+ * \post In each triple, the first string shall be less than or equal to the
+ * second in length
+ *
+ *
+ * In order to focus on the underlying algorithms for computing
+ * Damerau-Levenshtein distance, I've kept the format of test cases, and the
+ * files in which they may be recorded, as simple as possible:
+ *
+ * - ASCII text, or UTF-8 (the strings are just bytes to this function; it's
+ *   up to the caller to decode them, if the known distances are between
+ *   characters)
+ * - each line shall consist of three tab-delimited fields:
+ *   1. string A
+ *   2. string B
+ *   3. the known edit distance between them, expressed in base 10
+ *
+ * Lines with a '#' character in the first column will be considered
+ * comments & discarded.
+ *
+ * For instance:
+ *
+ \code
+ # Test file:
+ a\tb\t1
+ kitten\tsitting\t3
+ \endcode
+ *
+ *
+ * Nb this function will swap the two strings, if necessary, so that the second
+ * is at least as long as the first. This is to ensure that the precondition
+ * imposed by berghel_roach is met "up-front" and so we don't have to clutter
+ * the implementation, for now. I may come back & just update the implementation
+ * but for now I just want address issues #3 & #5.
+ *
+ *
+ */
+
+template <typename FOI> // Forward Output Iterator
+void
+read_corpus(const corpus_file &f, FOI pout)
+{
+  using namespace std;
+
+  auto parse_error = [&](size_t lineno) {
+    stringstream stm;
+    stm << "parse error in `" << f.path() << "', line " << lineno;
+    return runtime_error(stm.str());
+  };
+
+  string_view text = f.contents();
+  const char *p = text.data(), *pend = p + text.size();
+  for (size_t lineno = 1; p < pend; ++lineno) {
+    const char *eol = (const char*)memchr(p, '\n', pend - p);
+    if (!eol) eol = pend;
+    string_view line(p, eol - p);
+    p = eol + 1;
+
+    if (line.empty() || line[0] == '#') continue;
+    string_view::size_type idx0 = line.find('\t');
+    if (string_view::npos == idx0) {
+      throw parse_error(lineno);
+    }
+    string_view::size_type idx1 = line.find('\t', idx0 + 1);
+    if (string_view::npos == idx1) {
+      throw parse_error(lineno);
+    }
+
+    const char *q = line.data() + idx1 + 1, *qend = line.data() + line.size();
+    while (q < qend && (' ' == *q || '\t' == *q)) ++q;
+    size_t d;
+    if (from_chars(q, qend, d).ec != errc()) {
+      throw parse_error(lineno);
+    }
+
+    string_view A = line.substr(0, idx0);
+    string_view B = line.substr(idx0 + 1, idx1 - idx0 - 1);
+    if (A.length() < B.length()) {
+      *pout++ = test_case(A, B, d);
+    } else {
+      *pout++ = test_case(B, A, d);
+    }
+  }
+}
+
+/**
+ * \brief Read a list of words from file
+ *
+ *
+ * \param f [in] a text file containing one word per line
+ *
+ * \param pout [in,out] A forward output iterator to which each word read from
+ * \a f shall be copied, as a std::string_view into \a f
+ *
+ *
+ * As with read_corpus, lines with a '#' character in the first column are
+ * comments; empty lines are skipped.
+ *
+ *
+ */
+
+template <typename FOI> // Forward Output Iterator
+void
+read_words(const corpus_file &f, FOI pout)
+{
+  using namespace std;
+
+  string_view text = f.contents();
+  const char *p = text.data(), *pend = p + text.size();
+  while (p < pend) {
+    const char *eol = (const char*)memchr(p, '\n', pend - p);
+    if (!eol) eol = pend;
+    string_view line(p, eol - p);
+    p = eol + 1;
+
+    if (line.empty() || line[0] == '#') continue;
+    *pout++ = line;
+  }
+}
+
+/**
+ * \brief Read a cost policy from file
+ *
+ *
+ * \param f [in] a text file describing the cost of each edit (see below)
+ *
+ * \return a dl::cost_table holding the costs described in \a f
+ *
+ *
+ * Each line names a kind of edit & gives its cost, separated by whitespace:
+ *
+ \code
+ # Typing on a QWERTY keyboard
+ insertion 2
+ deletion 2
+ substitution 3
+ transposition 2
+ substitution q w 1
+ substitution w q 1
+ \endcode
+ *
+ * A line naming only the kind of edit sets the cost of every edit of that
+ * kind (one, if not given); substitutions & transpositions may instead be
+ * given for a pair of characters (single bytes), overriding that. As with
+ * read_corpus, lines with a '#' character in the first column are comments.
+ * Throws std::runtime_error on a malformed line.
+ *
+ *
+ */
+
+dl::cost_table
+read_costs(const corpus_file &f);
+
+#endif // CORPUS_HH_INCLUDED
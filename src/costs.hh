@@ -0,0 +1,182 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef COSTS_HH_INCLUDED
+#define COSTS_HH_INCLUDED 1
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/**
+ * \file costs.hh
+ *
+ * \brief Cost policies for weighted Damerau-Levenshtein distance
+ *
+ *
+ * The distance counts every insertion, deletion, substitution & transposition
+ * as one. Some applications would rather weigh them differently: an OCR
+ * engine confuses some characters far more often than others, & a typist is
+ * more likely to hit a key adjacent to the one intended than one across the
+ * keyboard. A cost policy says what each edit costs; it is a class with
+ *
+ * - a typedef `cost_type', the (arithmetic) type of its costs
+ * - insertion() & deletion(), the cost of inserting or deleting a character
+ * - substitution(a, b), the cost of replacing \a a with \a b (a != b)
+ * - transposition(a, b), the cost of turning "ab" into "ba"
+ *
+ * the last two being callable with characters of each type the policy is to
+ * be used with. A policy is handed to the templated overloads of
+ * dl::lowrance_wagner (see lw.hh), so that its costs are inlined into the
+ * recurrence.
+ *
+ * Only Lowrance & Wagner's recurrence can take arbitrary costs. Ukkonen's
+ * algorithm & that of Berghel & Roach compute, for each diagonal k & each
+ * distance p, the furthest row reachable at a cost of p, which supposes that
+ * costs are small integers (& that every edit costs the same); Hyyrö's
+ * encodes the differences of +/-1 between adjacent cells of the recurrence in
+ * bit-vectors. None of them can be weighted, nor can the prefilters,
+ * indices & searches built on them. Even Lowrance & Wagner's recurrence needs
+ * the full matrix once weighted: the tiled evaluation behind
+ * dl::lowrance_wagner relies on unit costs to confine the transposition term
+ * to the cells around each tile. For unit_costs, the templated overloads
+ * simply call the unweighted ones, at no cost.
+ *
+ * Lowrance & Wagner show that their recurrence gives the least cost of any
+ * sequence of edits provided that twice the cost of a transposition is at
+ * least the cost of an insertion plus that of a deletion; with cheaper
+ * transpositions, it yields an upper bound.
+ *
+ *
+ */
+
+namespace dl {
+
+  /// The cost policy under which every edit costs one
+  struct unit_costs {
+    typedef std::size_t cost_type;
+
+    cost_type insertion() const {
+      return 1;
+    }
+    cost_type deletion() const {
+      return 1;
+    }
+    template <typename CharT>
+    cost_type substitution(CharT, CharT) const {
+      return 1;
+    }
+    template <typename CharT>
+    cost_type transposition(CharT, CharT) const {
+      return 1;
+    }
+  };
+
+  /**
+   * \brief A cost policy read from tables
+   *
+   *
+   * Insertions & deletions each cost a fixed amount, while the costs of
+   * substitutions & transpositions are looked up, by pair of characters, in
+   * tables of 256 x 256 entries. Characters beyond 255 (in UTF-16 or UTF-32
+   * strings) aren't in the tables, & cost the defaults given at
+   * construction.
+   *
+   * Each table is 512KB, so a cost_table is best built once & shared (it is
+   * only read by dl::lowrance_wagner, so any number of threads may use it at
+   * once).
+   *
+   *
+   */
+
+  class cost_table
+  {
+  public:
+    typedef double cost_type;
+
+  public:
+    /// Construct a table in which every edit of each kind costs the same
+    explicit cost_table(double insertion = 1,
+                        double deletion = 1,
+                        double substitution = 1,
+                        double transposition = 1):
+      ins_(insertion), del_(deletion),
+      sub_default_(substitution), tra_default_(transposition),
+      sub_(256*256, substitution), tra_(256*256, transposition)
+    { }
+
+  public:
+    cost_type insertion() const {
+      return ins_;
+    }
+    cost_type deletion() const {
+      return del_;
+    }
+    /// Return the cost of replacing \a a with \a b
+    template <typename CharT>
+    cost_type substitution(CharT a, CharT b) const {
+      return lookup(sub_, sub_default_, a, b);
+    }
+    /// Return the cost of turning "ab" into "ba"
+    template <typename CharT>
+    cost_type transposition(CharT a, CharT b) const {
+      return lookup(tra_, tra_default_, a, b);
+    }
+    /// Set the cost of replacing \a a with \a b (both less than 256; throws
+    /// std::out_of_range otherwise)
+    template <typename CharT>
+    void set_substitution(CharT a, CharT b, double cost) {
+      sub_[index(a, b)] = cost;
+    }
+    /// Set the cost of turning "ab" into "ba" (\a a & \a b both less than
+    /// 256; throws std::out_of_range otherwise)
+    template <typename CharT>
+    void set_transposition(CharT a, CharT b, double cost) {
+      tra_[index(a, b)] = cost;
+    }
+
+  private:
+    template <typename CharT>
+    static cost_type lookup(const std::vector<double> &T,
+                            double dflt,
+                            CharT a,
+                            CharT b) {
+      typedef std::make_unsigned_t<CharT> uchar_type;
+      if constexpr (1 == sizeof(CharT)) {
+        return T[(uchar_type)a << 8 | (uchar_type)b];
+      } else {
+        return (uchar_type)a < 256 && (uchar_type)b < 256 ?
+          T[(uchar_type)a << 8 | (uchar_type)b] : dflt;
+      }
+    }
+    template <typename CharT>
+    static std::size_t index(CharT a, CharT b) {
+      typedef std::make_unsigned_t<CharT> uchar_type;
+      if ((uchar_type)a > 255 || (uchar_type)b > 255) {
+        throw std::out_of_range("cost_table only holds the costs of "
+                                "characters less than 256");
+      }
+      return (std::size_t)(uchar_type)a << 8 | (uchar_type)b;
+    }
+
+  private:
+    double ins_, del_, sub_default_, tra_default_;
+    std::vector<double> sub_, tra_;
+  };
+
+} // namespace dl
+
+#endif // COSTS_HH_INCLUDED
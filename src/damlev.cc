@@ -0,0 +1,333 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "damlev.hh"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+  template <typename CharT>
+  std::size_t
+  dispatch(std::basic_string_view<CharT> A,
+           std::basic_string_view<CharT> B,
+           dl::algorithm algo,
+           dl::workspace &ws)
+  {
+    using namespace dl;
+
+    switch (algo) {
+    case algorithm::lw:
+      return lowrance_wagner(A, B, ws);
+    case algorithm::uk:
+      return ukkonen(A, B, ws);
+    case algorithm::bp:
+      return hyyro(A, B, ws);
+    default:
+      return berghel_roach(A, B, ws);
+    }
+  }
+
+  template <typename CharT>
+  std::size_t
+  dispatch_within(std::basic_string_view<CharT> A,
+                  std::basic_string_view<CharT> B,
+                  std::size_t max_k,
+                  dl::algorithm algo,
+                  dl::workspace &ws)
+  {
+    using namespace dl;
+
+    std::size_t d;
+    if (prefilter(A, B, max_k, d)) {
+      return d;
+    }
+
+    switch (algo) {
+    case algorithm::lw:
+      return lowrance_wagner_within(A, B, max_k, ws);
+    case algorithm::uk:
+      return ukkonen_within(A, B, max_k, ws);
+    case algorithm::bp:
+      return hyyro_within(A, B, max_k, ws);
+    default:
+      return berghel_roach_within(A, B, max_k, ws);
+    }
+  }
+
+  template <typename CharT>
+  std::size_t
+  dispatch_within(std::basic_string_view<CharT> A,
+                  std::basic_string_view<CharT> B,
+                  std::size_t max_k,
+                  dl::variant var,
+                  dl::workspace &ws)
+  {
+    using namespace dl;
+
+    const std::size_t NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+    std::size_t d;
+    if (prefilter(A, B, max_k, d)) {
+      return d;
+    }
+    if (variant::osa == var) {
+      return NO_LIMIT == max_k ?
+        berghel_roach(A, B, ws) :
+        berghel_roach_within(A, B, max_k, ws);
+    }
+
+    // The two variants agree whenever the restricted distance is two or less,
+    // & the restricted distance is at most one exactly when the unrestricted
+    // distance is. Bounded by two, Berghel & Roach run in O(m+n)...
+    std::size_t k = std::min<std::size_t>(max_k, 2);
+    d = berghel_roach_within(A, B, k, ws);
+    if (d <= k || max_k <= 1) {
+      return d;
+    }
+
+    // & only if the restricted distance exceeds that do we need Lowrance &
+    // Wagner's recurrence.
+    if (NO_LIMIT == max_k) {
+      return lowrance_wagner(A, B, ws);
+    }
+    return lowrance_wagner_within(A, B, max_k, ws);
+  }
+
+}
+
+std::size_t
+dl::distance(std::string_view A,
+             std::string_view B,
+             algorithm algo)
+{
+  return dispatch(A, B, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::string_view A,
+             std::string_view B,
+             algorithm algo,
+             workspace &ws)
+{
+  return dispatch(A, B, algo, ws);
+}
+
+std::size_t
+dl::distance_within(std::string_view A,
+                    std::string_view B,
+                    std::size_t max_k,
+                    algorithm algo)
+{
+  return dispatch_within(A, B, max_k, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::string_view A,
+                    std::string_view B,
+                    std::size_t max_k,
+                    algorithm algo,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, algo, ws);
+}
+
+std::size_t
+dl::distance(std::u16string_view A,
+             std::u16string_view B,
+             algorithm algo)
+{
+  return dispatch(A, B, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::u16string_view A,
+             std::u16string_view B,
+             algorithm algo,
+             workspace &ws)
+{
+  return dispatch(A, B, algo, ws);
+}
+
+std::size_t
+dl::distance_within(std::u16string_view A,
+                    std::u16string_view B,
+                    std::size_t max_k,
+                    algorithm algo)
+{
+  return dispatch_within(A, B, max_k, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::u16string_view A,
+                    std::u16string_view B,
+                    std::size_t max_k,
+                    algorithm algo,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, algo, ws);
+}
+
+std::size_t
+dl::distance(std::u32string_view A,
+             std::u32string_view B,
+             algorithm algo)
+{
+  return dispatch(A, B, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::u32string_view A,
+             std::u32string_view B,
+             algorithm algo,
+             workspace &ws)
+{
+  return dispatch(A, B, algo, ws);
+}
+
+std::size_t
+dl::distance_within(std::u32string_view A,
+                    std::u32string_view B,
+                    std::size_t max_k,
+                    algorithm algo)
+{
+  return dispatch_within(A, B, max_k, algo, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::u32string_view A,
+                    std::u32string_view B,
+                    std::size_t max_k,
+                    algorithm algo,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, algo, ws);
+}
+
+std::size_t
+dl::distance(std::string_view A,
+             std::string_view B,
+             variant var)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::string_view A,
+             std::string_view B,
+             variant var,
+             workspace &ws)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         ws);
+}
+
+std::size_t
+dl::distance_within(std::string_view A,
+                    std::string_view B,
+                    std::size_t max_k,
+                    variant var)
+{
+  return dispatch_within(A, B, max_k, var, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::string_view A,
+                    std::string_view B,
+                    std::size_t max_k,
+                    variant var,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, var, ws);
+}
+
+std::size_t
+dl::distance(std::u16string_view A,
+             std::u16string_view B,
+             variant var)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::u16string_view A,
+             std::u16string_view B,
+             variant var,
+             workspace &ws)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         ws);
+}
+
+std::size_t
+dl::distance_within(std::u16string_view A,
+                    std::u16string_view B,
+                    std::size_t max_k,
+                    variant var)
+{
+  return dispatch_within(A, B, max_k, var, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::u16string_view A,
+                    std::u16string_view B,
+                    std::size_t max_k,
+                    variant var,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, var, ws);
+}
+
+std::size_t
+dl::distance(std::u32string_view A,
+             std::u32string_view B,
+             variant var)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         this_thread_workspace());
+}
+
+std::size_t
+dl::distance(std::u32string_view A,
+             std::u32string_view B,
+             variant var,
+             workspace &ws)
+{
+  return dispatch_within(A, B, std::numeric_limits<std::size_t>::max(), var,
+                         ws);
+}
+
+std::size_t
+dl::distance_within(std::u32string_view A,
+                    std::u32string_view B,
+                    std::size_t max_k,
+                    variant var)
+{
+  return dispatch_within(A, B, max_k, var, this_thread_workspace());
+}
+
+std::size_t
+dl::distance_within(std::u32string_view A,
+                    std::u32string_view B,
+                    std::size_t max_k,
+                    variant var,
+                    workspace &ws)
+{
+  return dispatch_within(A, B, max_k, var, ws);
+}
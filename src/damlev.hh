@@ -0,0 +1,398 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef DAMLEV_HH_INCLUDED
+#define DAMLEV_HH_INCLUDED 1
+
+#include <cstddef>
+#include <string_view>
+
+#include "bktree.hh"
+#include "bp.hh"
+#include "br.hh"
+#include "costs.hh"
+#include "deletion.hh"
+#include "filter.hh"
+#include "index_file.hh"
+#include "lw.hh"
+#include "nearest.hh"
+#include "query.hh"
+#include "script.hh"
+#include "synth.hh"
+#include "trie.hh"
+#include "uk.hh"
+#include "utf8.hh"
+#include "workspace.hh"
+
+/**
+ * \file damlev.hh
+ *
+ * \brief Public interface to the damerau-levenshtein library
+ *
+ *
+ * Each of the algorithms in this package may be called directly (see lw.hh,
+ * uk.hh, br.hh & bp.hh); this header adds a single entry point that dispatches
+ * to whichever algorithm the caller prefers.
+ *
+ * Every function comes in two flavors: one that works in the calling thread's
+ * workspace & one that takes a workspace explicitly (see workspace.hh).
+ *
+ * Callers comparing one string against many should prefer dl::query (see
+ * query.hh), which pre-processes that string once; callers wanting only the
+ * closest few of many candidates should use dl::nearest (see nearest.hh).
+ * Callers searching the same dictionary over & over should index it (see
+ * bktree.hh, trie.hh & deletion.hh), & may save the index to disk to be
+ * mapped back in by later processes (see index_file.hh). Callers wanting to
+ * know not just how far apart two strings are but what the edits are should
+ * see script.hh. Only Lowrance & Wagner's algorithm can weigh some edits more
+ * heavily than others (see costs.hh). Synthetic pairs of strings a known
+ * number of edits apart, for testing & benchmarking, may be had from
+ * dl::pair_generator (see synth.hh).
+ *
+ * \section variants Restricted & unrestricted distances
+ *
+ * Lowrance & Wagner compute the "unrestricted" Damerau-Levenshtein distance;
+ * Ukkonen, Berghel & Roach & Hyyrö compute the "restricted" distance (also
+ * known as the "optimal string alignment" distance), in which no substring
+ * may be edited more than once. The two differ when the cheapest way from
+ * one string to the other edits something twice: "ca" is two edits from
+ * "abc" (transpose, then insert "b" between the two), but three when that's
+ * forbidden. Only the unrestricted distance satisfies the triangle
+ * inequality. Callers who care which they get, rather than which algorithm
+ * computes it, should name a dl::variant rather than a dl::algorithm.
+ *
+ * \section char_types Character types
+ *
+ * Every function comes in three flavors of string, as well: std::string_view,
+ * std::u16string_view & std::u32string_view. In each case, the strings are
+ * compared element-by-element: a std::string_view holding UTF-8 is compared
+ * byte-by-byte, so that a single substituted non-ASCII character may count
+ * as several edits. To compare text character-by-character, decode it first
+ * (see dl::utf8_decode in utf8.hh) & hand the results to the
+ * std::u32string_view overloads. Those overloads will just as happily take
+ * any other sequence of 32-bit tokens (word or phoneme identifiers, for
+ * instance), stored as char32_t.
+ *
+ * Where an algorithm needs a per-character table, it's indexed directly when
+ * every character involved is less than 256; otherwise, it becomes a small
+ * hash table keyed on the characters actually present, so that neither time
+ * nor space grows with the size of the alphabet. The vectorized kernel of
+ * lowrance_wagner is only available for narrow strings.
+ *
+ *
+ */
+
+namespace dl {
+
+  /// The algorithms available for computing Damerau-Levenshtein distance
+  enum class algorithm {
+    /// Lowrance & Wagner (1975)
+    lw,
+    /// Ukkonen (1985)
+    uk,
+    /// Berghel & Roach (1996)
+    br,
+    /// Hyyrö (2002)
+    bp
+  };
+
+  /// The two variants of the Damerau-Levenshtein distance
+  enum class variant {
+    /// The restricted, or "optimal string alignment", distance, in which no
+    /// substring may be edited more than once
+    osa,
+    /// The unrestricted distance, which is a metric
+    unrestricted
+  };
+
+  /// Return the variant of the distance computed by \a algo
+  constexpr variant
+  variant_of(algorithm algo)
+  {
+    return algorithm::lw == algo ? variant::unrestricted : variant::osa;
+  }
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param algo [in] the algorithm to be used
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B
+   *
+   *
+   */
+
+  std::size_t
+  distance(std::string_view A,
+           std::string_view B,
+           algorithm algo = algorithm::br);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B using
+  /// \a algo in the workspace \a ws
+  std::size_t
+  distance(std::string_view A,
+           std::string_view B,
+           algorithm algo,
+           workspace &ws);
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings, giving
+   * up once it is known to exceed a given threshold
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \param algo [in] the algorithm to be used
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B if that is
+   * less than or equal to \a max_k, or \a max_k + 1 otherwise
+   *
+   *
+   * Most fuzzy-matching applications only care whether two strings are "close
+   * enough"; for them, this is considerably cheaper than distance, since the
+   * work done by Ukkonen's algorithm & that of Berghel & Roach grows with the
+   * distance computed, rather than with the lengths of the strings.
+   *
+   * Before handing the strings to \a algo, this applies the cheap tests of
+   * dl::prefilter, which settle many comparisons outright.
+   *
+   *
+   */
+
+  std::size_t
+  distance_within(std::string_view A,
+                  std::string_view B,
+                  std::size_t max_k,
+                  algorithm algo = algorithm::br);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B, up to
+  /// \a max_k, using \a algo in the workspace \a ws
+  std::size_t
+  distance_within(std::string_view A,
+                  std::string_view B,
+                  std::size_t max_k,
+                  algorithm algo,
+                  workspace &ws);
+
+  /// As above, for strings of 16-bit characters
+  std::size_t
+  distance(std::u16string_view A,
+           std::u16string_view B,
+           algorithm algo = algorithm::br);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::size_t
+  distance(std::u16string_view A,
+           std::u16string_view B,
+           algorithm algo,
+           workspace &ws);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k
+  std::size_t
+  distance_within(std::u16string_view A,
+                  std::u16string_view B,
+                  std::size_t max_k,
+                  algorithm algo = algorithm::br);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  distance_within(std::u16string_view A,
+                  std::u16string_view B,
+                  std::size_t max_k,
+                  algorithm algo,
+                  workspace &ws);
+
+  /// As above, for strings of 32-bit characters
+  std::size_t
+  distance(std::u32string_view A,
+           std::u32string_view B,
+           algorithm algo = algorithm::br);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::size_t
+  distance(std::u32string_view A,
+           std::u32string_view B,
+           algorithm algo,
+           workspace &ws);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k
+  std::size_t
+  distance_within(std::u32string_view A,
+                  std::u32string_view B,
+                  std::size_t max_k,
+                  algorithm algo = algorithm::br);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  distance_within(std::u32string_view A,
+                  std::u32string_view B,
+                  std::size_t max_k,
+                  algorithm algo,
+                  workspace &ws);
+
+  /**
+   * \brief Compute either variant of the Damerau-Levenshtein distance between
+   * two strings
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param var [in] the variant of the distance to be computed
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B, of
+   * variant \a var
+   *
+   *
+   * The restricted distance is computed by Berghel & Roach, the unrestricted
+   * by Lowrance & Wagner, in O(m+n) space (see lw.hh).
+   *
+   * The unrestricted distance is never greater than the restricted, & the two
+   * agree whenever the restricted distance is two or less: only identical
+   * strings are zero apart under either, & a single edit is a single edit
+   * under either. Deciding whether the restricted distance is that small
+   * costs Berghel & Roach O(m+n), so that's done first, & Lowrance & Wagner's
+   * O(m*n) recurrence is only run on pairs that are further apart.
+   *
+   *
+   */
+
+  std::size_t
+  distance(std::string_view A,
+           std::string_view B,
+           variant var);
+
+  /// Compute the variant \a var of the Damerau-Levenshtein distance between
+  /// \a A & \a B in the workspace \a ws
+  std::size_t
+  distance(std::string_view A,
+           std::string_view B,
+           variant var,
+           workspace &ws);
+
+  /**
+   * \brief Compute either variant of the Damerau-Levenshtein distance between
+   * two strings, giving up once it is known to exceed a given threshold
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \param var [in] the variant of the distance to be computed
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B, of
+   * variant \a var, if that is less than or equal to \a max_k, or
+   * \a max_k + 1 otherwise
+   *
+   *
+   * As distance_within, above, with Berghel & Roach's algorithm for the
+   * restricted distance & Lowrance & Wagner's for the unrestricted. Since the
+   * unrestricted distance is at most one exactly when the restricted distance
+   * is, the latter settles every comparison with \a max_k of one or less.
+   *
+   *
+   */
+
+  std::size_t
+  distance_within(std::string_view A,
+                  std::string_view B,
+                  std::size_t max_k,
+                  variant var);
+
+  /// Compute the variant \a var of the Damerau-Levenshtein distance between
+  /// \a A & \a B, up to \a max_k, in the workspace \a ws
+  std::size_t
+  distance_within(std::string_view A,
+                  std::string_view B,
+                  std::size_t max_k,
+                  variant var,
+                  workspace &ws);
+
+  /// As above, for strings of 16-bit characters
+  std::size_t
+  distance(std::u16string_view A,
+           std::u16string_view B,
+           variant var);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::size_t
+  distance(std::u16string_view A,
+           std::u16string_view B,
+           variant var,
+           workspace &ws);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k
+  std::size_t
+  distance_within(std::u16string_view A,
+                  std::u16string_view B,
+                  std::size_t max_k,
+                  variant var);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  distance_within(std::u16string_view A,
+                  std::u16string_view B,
+                  std::size_t max_k,
+                  variant var,
+                  workspace &ws);
+
+  /// As above, for strings of 32-bit characters
+  std::size_t
+  distance(std::u32string_view A,
+           std::u32string_view B,
+           variant var);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::size_t
+  distance(std::u32string_view A,
+           std::u32string_view B,
+           variant var,
+           workspace &ws);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k
+  std::size_t
+  distance_within(std::u32string_view A,
+                  std::u32string_view B,
+                  std::size_t max_k,
+                  variant var);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  distance_within(std::u32string_view A,
+                  std::u32string_view B,
+                  std::size_t max_k,
+                  variant var,
+                  workspace &ws);
+
+} // namespace dl
+
+#endif // DAMLEV_HH_INCLUDED
@@ -0,0 +1,273 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "deletion.hh"
+#include "br.hh"
+#include "filter.hh"
+#include "parallel.hh"
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+  /// Hash \a n characters at \a p (FNV-1a, with a final mix so that the high
+  /// bits, which pick the slot, depend on every character)
+  template <typename CharT>
+  std::uint64_t
+  hash_chars(const CharT *p, std::size_t n)
+  {
+    typedef std::make_unsigned_t<CharT> uchar_type;
+    std::uint64_t h = UINT64_C(0xcbf29ce484222325);
+    for (std::size_t i = 0; i < n; ++i) {
+      h ^= (uchar_type)p[i];
+      h *= UINT64_C(0x100000001b3);
+    }
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    return h;
+  }
+
+  /// Generates the hashes of the deletion variants of a string, re-using its
+  /// buffers from one string to the next
+  template <typename CharT>
+  class variant_generator
+  {
+  public:
+    /// Append to \a out the hash of every string obtained by deleting up to
+    /// \a k characters from \a w (sorted, without duplicates)
+    void operator()(std::basic_string_view<CharT> w,
+                    std::size_t k,
+                    std::vector<std::uint64_t> &out)
+    {
+      if (bufs_.size() < k + 1) bufs_.resize(k + 1);
+      bufs_[0].assign(w.data(), w.length());
+      std::size_t n0 = out.size();
+      generate(0, k, 0, out);
+      std::sort(out.begin() + n0, out.end());
+      out.erase(std::unique(out.begin() + n0, out.end()), out.end());
+    }
+
+  private:
+    // Deleting positions in increasing order (each deletion at or after the
+    // last, in the shortened string) visits each set of positions once.
+    void generate(std::size_t level,
+                  std::size_t k,
+                  std::size_t from,
+                  std::vector<std::uint64_t> &out)
+    {
+      const std::basic_string<CharT> &s = bufs_[level];
+      out.push_back(hash_chars(s.data(), s.length()));
+      if (level == k) {
+        return;
+      }
+      std::basic_string<CharT> &t = bufs_[level + 1];
+      for (std::size_t i = from; i < s.length(); ++i) {
+        t.assign(s, 0, i);
+        t.append(s, i + 1, std::basic_string<CharT>::npos);
+        generate(level + 1, k, i, out);
+      }
+    }
+
+  private:
+    std::vector<std::basic_string<CharT>> bufs_;
+  };
+
+}
+
+template <typename CharT>
+void
+dl::basic_deletion_index<CharT>::build(unsigned num_threads)
+{
+  using namespace std;
+
+  size_t n = size();
+  if (n >= numeric_limits<uint32_t>::max()) {
+    throw length_error("too many words for a deletion index");
+  }
+
+  // Generate each chunk's (hash, word) pairs on whichever thread gets to it...
+  const size_t CHUNK = 1024;
+  typedef pair<uint64_t, uint32_t> entry;
+  vector<vector<entry>> parts((n + CHUNK - 1) / CHUNK);
+  parallel_for(n, CHUNK, num_threads,
+               [&](unsigned, size_t c, size_t i0, size_t i1) {
+    variant_generator<CharT> gen;
+    vector<uint64_t> H;
+    for (size_t i = i0; i < i1; ++i) {
+      H.clear();
+      gen(word(i), max_k_, H);
+      for (uint64_t h: H) {
+        parts[c].push_back(entry(h, (uint32_t)i));
+      }
+    }
+  });
+
+  // distribute them among buckets by the top bits of their hashes...
+  const unsigned BUCKET_BITS = 16;
+  vector<size_t> bucket(((size_t)1 << BUCKET_BITS) + 1, 0);
+  size_t total = 0;
+  for (const auto &P: parts) {
+    for (const entry &e: P) ++bucket[(e.first >> (64 - BUCKET_BITS)) + 1];
+    total += P.size();
+  }
+  if (total >= numeric_limits<uint32_t>::max()) {
+    throw length_error("too many deletion variants for a deletion index");
+  }
+  for (size_t b = 1; b < bucket.size(); ++b) {
+    bucket[b] += bucket[b-1];
+  }
+  vector<entry> all(total);
+  {
+    vector<size_t> next(bucket.begin(), bucket.end() - 1);
+    for (auto &P: parts) {
+      for (const entry &e: P) all[next[e.first >> (64 - BUCKET_BITS)]++] = e;
+      vector<entry>().swap(P);
+    }
+  }
+
+  // & sort each bucket (again, on several threads), which sorts the lot.
+  parallel_for(bucket.size() - 1, 256, num_threads,
+               [&](unsigned, size_t, size_t b0, size_t b1) {
+    for (size_t b = b0; b < b1; ++b) {
+      sort(all.begin() + bucket[b], all.begin() + bucket[b+1]);
+    }
+  });
+
+  // Finally, lay out the table. Since the slot at which each key starts
+  // probing is given by its top bits, inserting the keys in sorted order
+  // proceeds through the table from front to back.
+  for (size_t i = 0; i < total; ++i) {
+    if (0 == i || all[i].first != all[i-1].first) ++num_keys_;
+  }
+  bits_ = 1;
+  while (((size_t)1 << bits_) < 2 * num_keys_) ++bits_;
+  size_t mask = ((size_t)1 << bits_) - 1;
+  vector<slot> slots(mask + 1, slot{0, 0, 0});
+  vector<uint32_t> postings(total);
+  for (size_t i = 0; i < total; ) {
+    uint64_t key = all[i].first;
+    size_t first = i;
+    for ( ; i < total && all[i].first == key; ++i) {
+      postings[i] = all[i].second;
+    }
+    size_t s = (size_t)(key >> (64 - bits_));
+    while (slots[s].count) s = (s + 1) & mask;
+    slots[s] = slot{key, (uint32_t)first, (uint32_t)(i - first)};
+  }
+  slots_.assign(move(slots));
+  postings_.assign(move(postings));
+}
+
+template <typename CharT>
+dl::basic_deletion_index<CharT>::basic_deletion_index(const index_file &f)
+{
+  f.expect(index_kind::deletion, sizeof(CharT));
+  f.section(0, text_);
+  f.section(1, offsets_);
+  f.section(2, slots_);
+  f.section(3, postings_);
+  max_k_ = f.param(0);
+  bits_ = (unsigned)f.param(1);
+  num_keys_ = f.param(2);
+  if (offsets_.empty() || offsets_.back() != text_.size() ||
+      bits_ < 1 || bits_ > 63 || slots_.size() != ((std::size_t)1 << bits_)) {
+    throw std::runtime_error("malformed deletion index");
+  }
+}
+
+template <typename CharT>
+void
+dl::basic_deletion_index<CharT>::save(const std::string &pth) const
+{
+  write_index_file(pth, index_kind::deletion, sizeof(CharT),
+                   {(std::uint64_t)max_k_, bits_, (std::uint64_t)num_keys_},
+                   {text_, offsets_, slots_, postings_});
+}
+
+template <typename CharT>
+void
+dl::basic_deletion_index<CharT>::search(view_type q,
+                                        std::size_t max_k,
+                                        std::vector<match> &out,
+                                        workspace &ws,
+                                        search_stats *stats) const
+{
+  using namespace std;
+
+  if (max_k > max_k_) {
+    throw invalid_argument("a deletion index built for distances up to " +
+                           to_string(max_k_) + " can't be searched for " +
+                           to_string(max_k));
+  }
+
+  static thread_local variant_generator<CharT> gen;
+  static thread_local vector<uint64_t> H;
+  static thread_local vector<uint32_t> C;
+
+  // Collect every word sharing a deletion variant with the query...
+  H.clear();
+  C.clear();
+  if (!slots_.empty()) {
+    gen(q, max_k, H);
+  }
+  size_t mask = slots_.size() - 1;
+  for (uint64_t h: H) {
+    for (size_t s = (size_t)(h >> (64 - bits_)); slots_[s].count;
+         s = (s + 1) & mask) {
+      if (slots_[s].key == h) {
+        auto p = postings_.begin() + slots_[s].first;
+        C.insert(C.end(), p, p + slots_[s].count);
+        break;
+      }
+    }
+  }
+  sort(C.begin(), C.end());
+  C.erase(unique(C.begin(), C.end()), C.end());
+
+  // & confirm each.
+  for (uint32_t id: C) {
+    view_type a = q, b = word(id);
+    size_t d;
+    if (!prefilter(a, b, max_k, d)) {
+      d = berghel_roach_within(a, b, max_k, ws);
+    }
+    if (d <= max_k) {
+      out.push_back(match{id, d});
+    }
+  }
+
+  if (stats) {
+    ++stats->queries;
+    stats->evaluations += C.size();
+    stats->entries += size();
+  }
+}
+
+template <typename CharT>
+std::vector<dl::match>&
+dl::basic_deletion_index<CharT>::matches_buffer()
+{
+  static thread_local std::vector<match> M;
+  return M;
+}
+
+template class dl::basic_deletion_index<char>;
+template class dl::basic_deletion_index<char16_t>;
+template class dl::basic_deletion_index<char32_t>;
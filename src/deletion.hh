@@ -0,0 +1,223 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef DELETION_HH_INCLUDED
+#define DELETION_HH_INCLUDED 1
+
+#include "index_file.hh"
+#include "query.hh"
+#include "workspace.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /**
+   * \brief A symmetric-delete index: an index over a dictionary of words
+   * supporting "find all words within distance k of this one" for very small
+   * k by way of hashing rather than dynamic programming
+   *
+   *
+   * If two strings are within k of one another, then deleting at most k
+   * characters from each yields a common string: a change, or a transposition
+   * of adjacent characters, is undone by deleting one character from each
+   * side, & an insertion or deletion by deleting one character from one side.
+   * So if every way of deleting up to k characters from every word is
+   * recorded in a hash table (along with the word from which it came), the
+   * candidates for a query are just the words recorded against any of its
+   * own deletion variants. This is the idea behind Garbe's SymSpell. Each
+   * candidate is then confirmed with dl::berghel_roach_within, so the results
+   * are exactly those a linear scan with dl::berghel_roach_within would
+   * produce (the restricted distance, unlike dl::bk_tree & dl::trie).
+   *
+   * A word of length n has on the order of n^k deletion variants, so the
+   * index is only practical for k of one or two (& a query costs on the
+   * order of |q|^k lookups).
+   *
+   * The variants themselves aren't stored, only 64-bit hashes of them; a
+   * collision merely produces an extra candidate, which fails confirmation.
+   * The table is a flat, open-addressed (linear probing) array of
+   * (hash, postings) slots, the postings (word indices) for all the hashes
+   * being concatenated in one more array. Nothing in either is a pointer, so
+   * the index may be saved to disk & mapped back in (see dl::index_file).
+   * Building the index generates & sorts the variants on as many threads as
+   * the caller likes.
+   *
+   * An index is immutable once constructed & so may be shared between
+   * threads, each of which should supply its own workspace.
+   *
+   * Strings of char are compared byte by byte; use
+   * basic_deletion_index<char32_t> (u32deletion_index) to compare decoded
+   * text (see dl::utf8_decode).
+   *
+   *
+   */
+
+  template <typename CharT>
+  class basic_deletion_index
+  {
+  public:
+    typedef std::basic_string_view<CharT> view_type;
+
+  public:
+    /**
+     * \brief Index a range of words
+     *
+     *
+     * \param p0 [in] the first word; each must be convertible to view_type
+     *
+     * \param p1 [in] one past the last word
+     *
+     * \param max_k [in] the largest distance that will be searched for
+     *
+     * \param num_threads [in] the number of threads on which to build the
+     * index (including the calling thread)
+     *
+     *
+     * Throws std::length_error if there are too many words or variants.
+     *
+     *
+     */
+
+    template <typename FII>
+    basic_deletion_index(FII p0, FII p1, std::size_t max_k,
+                         unsigned num_threads = 1):
+      max_k_(max_k)
+    {
+      std::vector<CharT> text;
+      std::vector<std::uint64_t> offsets(1, 0);
+      for ( ; p0 != p1; ++p0) {
+        view_type w(*p0);
+        text.insert(text.end(), w.begin(), w.end());
+        offsets.push_back(text.size());
+      }
+      text_.assign(std::move(text));
+      offsets_.assign(std::move(offsets));
+      build(num_threads);
+    }
+    /// Load an index saved to \a f, which must outlive it; throws
+    /// std::runtime_error if \a f holds some other sort of index
+    explicit basic_deletion_index(const index_file &f);
+
+  public:
+    /// Save this index to \a pth (see dl::index_file); throws
+    /// std::system_error on failure
+    void save(const std::string &pth) const;
+
+  public:
+    /// Return the number of words in the dictionary
+    std::size_t size() const {
+      return offsets_.size() - 1;
+    }
+    /// Return the \a i-th word given at construction
+    view_type word(std::size_t i) const {
+      return view_type(text_.data() + offsets_[i],
+                       offsets_[i+1] - offsets_[i]);
+    }
+    /// Return the largest distance for which this index may be searched
+    std::size_t max_k() const {
+      return max_k_;
+    }
+    /// Return the number of distinct deletion variants (or rather, of their
+    /// hashes) in the index
+    std::size_t variants() const {
+      return num_keys_;
+    }
+
+    /**
+     * \brief Find the words within a given distance of a query
+     *
+     *
+     * \param q [in] the query
+     *
+     * \param max_k [in] the largest distance of interest to the caller; this
+     * may not exceed max_k() (std::invalid_argument is thrown if it does)
+     *
+     * \param pout [in] a forward output iterator to which a dl::match shall be
+     * written for each word no more than \a max_k from \a q (in no particular
+     * order); each match's index is the word's position in the range from
+     * which the index was built
+     *
+     * \param ws [in,out] the workspace in which to carry-out each comparison
+     *
+     * \param stats [in,out] if non-null, the cost of this search will be added
+     * to it
+     *
+     * \return \a pout, advanced past the last match written
+     *
+     *
+     */
+
+    template <typename FOI>
+    FOI
+    range_query(view_type q,
+                std::size_t max_k,
+                FOI pout,
+                workspace &ws,
+                search_stats *stats = nullptr) const
+    {
+      std::vector<match> &M = matches_buffer();
+      M.clear();
+      search(q, max_k, M, ws, stats);
+      return std::copy(M.begin(), M.end(), pout);
+    }
+
+  private:
+    void build(unsigned num_threads);
+    void search(view_type q,
+                std::size_t max_k,
+                std::vector<match> &out,
+                workspace &ws,
+                search_stats *stats) const;
+    static std::vector<match>& matches_buffer();
+
+  private:
+    struct slot {
+      /// The hash of a deletion variant
+      std::uint64_t key;
+      /// The words having that variant are postings_[first, first + count);
+      /// a slot with a count of zero is empty
+      std::uint32_t first, count;
+    };
+
+    /// The words, end-to-end; word i is text_[offsets_[i], offsets_[i+1])
+    index_array<CharT> text_;
+    index_array<std::uint64_t> offsets_;
+    std::size_t max_k_;
+    /// The hash table; its size is a power of two
+    index_array<slot> slots_;
+    /// log2(slots_.size())
+    unsigned bits_ = 0;
+    std::size_t num_keys_ = 0;
+    /// The word indices for each hash, sorted within each
+    index_array<std::uint32_t> postings_;
+  };
+
+  typedef basic_deletion_index<char> deletion_index;
+  typedef basic_deletion_index<char16_t> u16deletion_index;
+  typedef basic_deletion_index<char32_t> u32deletion_index;
+
+  extern template class basic_deletion_index<char>;
+  extern template class basic_deletion_index<char16_t>;
+  extern template class basic_deletion_index<char32_t>;
+
+} // namespace dl
+
+#endif // DELETION_HH_INCLUDED
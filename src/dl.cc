@@ -22,104 +22,164 @@
 #include <chrono>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <memory>
+#include <atomic>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
-#include "lw.hh"
-#include "uk.hh"
-#include "br.hh"
+#include "corpus.hh"
+#include "gen.hh"
+#include "harness.hh"
+#include "parallel.hh"
+#include "perf.hh"
+#include "search.hh"
+#include "stream.hh"
 
-enum class algorithm { lw, uk, br };
+using dl::algorithm;
 
-/// A test case for computing the edit distance between two strings: a three
-/// tuple consisting of string "A", string "B", and the known edit distance
-/// between them
-typedef std::tuple<std::string, std::string, size_t> test_case;
+/// How the `dl' driver is to go over a corpus of test cases; filled in by
+/// main from the command line
+struct corpus_options {
+  /// The algorithm to be exercised
+  algorithm algo = algorithm::br;
+  /// If true, treat each run of test cases sharing the same first string as a
+  /// one-vs-many comparison, to be scored by a single dl::query (\a algo must
+  /// be algorithm::bp)
+  bool batch = false;
+  /// If true, recover an edit script for each test case with
+  /// dl::edit_script, check that it turns A into B at a cost of D, & (if
+  /// \a verbose) print it (\a algo must be algorithm::lw)
+  bool edits = false;
+  /// If non-null, weigh each edit according to it, rather than counting them
+  /// (\a algo must be algorithm::lw)
+  const dl::cost_table *costs = nullptr;
+  /// If true, compute both the restricted & unrestricted distance for each
+  /// test case, print those on which they disagree, & check the one computed
+  /// by \a algo against the known distance
+  bool cross_check = false;
+  /// If true, produce verbose status messages on stdout; this is intended for
+  /// debugging & trouble-shooting; turning this feature on with a large
+  /// corpus of test data will likely be unhelpful
+  bool verbose = false;
+  /// If true, randomize the order of traversal through the corpus of test
+  /// data; specify this on successive runs to defeat any sort of branch
+  /// prediction, cache warming or other black magic going on that could
+  /// affect test timings
+  bool randomize = false;
+  /// The number of times to go over the corpus; to get reliable timings over
+  /// a small set of test cases, you might want to set this to a large number
+  /// & set \a randomize to true. The test cases will be shuffled before each
+  /// iteration, and the time spent shuffling will not be included in the
+  /// reported timings
+  size_t num_loops = 1;
+  /// The largest distance of interest; if this is less than NO_MAX_K, the
+  /// bounded version of \a algo will be exercised & any test case whose known
+  /// distance exceeds \a max_k will be expected to come back as \a max_k + 1
+  size_t max_k = NO_MAX_K;
+  /// If true, apply dl::prefilter ahead of \a algo & report how many
+  /// comparisons were settled at each stage
+  bool prefilter = false;
+  /// If true, take the test cases to be UTF-8 & compute the distance between
+  /// the code points they encode, rather than their bytes
+  bool utf8 = false;
+  /// The number of threads over which to spread the corpus. The corpus is
+  /// broken into chunks which are handed out to the threads (with
+  /// work-stealing, so that no thread sits idle while there is work to be
+  /// done); each thread has its own workspace. Verbose output is collected
+  /// per-chunk & printed in corpus order, so that the output is the same no
+  /// matter how many threads are used
+  unsigned num_threads = 1;
+  /// If true, rather than spread the corpus over \a num_threads threads,
+  /// compare its pairs one at a time, spreading each comparison over them
+  /// (\a algo must be algorithm::lw)
+  bool wavefront = false;
+  /// If true, print the time, in milliseconds on the system clock, spent
+  /// going over the test cases, exclusive of any shuffling that may have been
+  /// done (when using multiple threads, this is the elapsed time, not the sum
+  /// of the time spent on each thread). If you have a large test corpus, you
+  /// may instead just run this with \a num_loops = 1, \a randomize false, and
+  /// just run the program under `time'. Along with the time, print the work
+  /// done by the algorithm (see dl::work_stats) & the CPU's performance
+  /// counters over the same interval, where they're available (see
+  /// perf_counters)
+  bool print_timings = false;
+};
 
 /**
- * \brief Read a collection of test cases from file
- *
+ * \brief Exercise a selected algorithm over a range of test cases
  *
- * \param pth [in] a path, absolute or relative to the present working
- * directory, to an ASCII text file containing one or more test cases (see below
- * for expected format)
  *
- * \param pout [in,out] A forward output iterator two which each test case read
- * from \a pth shall be copied
+ * \param opts [in] How the test cases are to be exercised; only \a algo,
+ * \a batch, \a edits, \a costs, \a max_k & \a utf8 are consulted here
  *
- * \post In each triple, the first string shall be less than or equal to the
- * second in length
+ * \param xout [in] If non-null, compute both variants of the distance with
+ * dl::distance & write each test case on which they disagree here; the known
+ * distances are taken to be of the variant computed by \a opts.algo
  *
+ * \param p0 [in] A random access iterator referencing the beginning of a
+ * range of test cases
  *
- * In order to focus on the underlying algorithms for computing
- * Damerau-Levenshtein distance, I've kept the format of test cases, and the
- * files in which they may be recorded, as simple as possible:
+ * \param p1 [in] A random access iterator referencing the one-past-the-end
+ * position of a range of test cases
  *
- * - ASCII text only
- * - each line shall consist of three tab-delimited fields:
- *   1. string A
- *   2. string B
- *   3. the known edit distance between them, expressed in base 10
+ * \param inf [in] Maximum length across all strings in the test corpus
  *
- * Lines with a '#' character in the first column will be considered
- * comments & discarded.
+ * \param filters [in,out] If non-null, apply dl::prefilter ahead of the
+ * algorithm & tally the stage settling each comparison here
  *
- * For instance:
+ * \param ws [in,out] The workspace in which to carry-out each comparison
  *
- \code
- # Test file:
- a\tb\t1
- kitten\tsitting\t3
- \endcode
+ * \param tile_threads [in] The number of threads over which to spread each
+ * comparison (\a opts.algo must be algorithm::lw, if this exceeds one)
  *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
  *
- * Nb this function will swap the two strings, if necessary, so that the second
- * is at least as long as the first. This is to ensure that the precondition
- * imposed by berghel_roach is met "up-front" and so we don't have to clutter
- * the implementation, for now. I may come back & just update the implementation
- * but for now I just want address issues #3 & #5.
+ * \return true if the algorithm calculated the known D-L edit distance for
+ * each case in [p0, p1), false else
  *
  *
  */
 
-template <typename FOI> // Forward Output Iterator
-void
-read_corpus(const std::filesystem::path &pth, FOI pout)
+template <typename RAI> // Random Access Iterator
+bool
+test_range(const corpus_options &opts,
+           std::ostream  *xout,
+           RAI           p0,
+           RAI           p1,
+           size_t        inf,
+           dl::filter_stats *filters,
+           dl::workspace &ws,
+           unsigned      tile_threads,
+           std::ostream  *verb)
 {
-  using namespace std;
-
-  ifstream in(pth);
-  size_t lineno = 1;
-  for (string line; getline(in, line); ++lineno) {
-    if (line.empty() || line[0] == '#') continue;
-    string::size_type idx0 = line.find('\t');
-    if (string::npos == idx0) {
-      stringstream stm;
-      stm << "parse error in `" << pth << "', line " << lineno;
-      throw std::runtime_error(stm.str());
-    }
-    string::size_type idx1 = line.find('\t', idx0 + 1);
-    if (string::npos == idx1) {
-      stringstream stm;
-      stm << "parse error in `" << pth << "', line " << lineno;
-      throw std::runtime_error(stm.str());
-    }
-
-    if (idx0 < idx1 - idx0 - 1) {
-        *pout++ = make_tuple(line.substr(0, idx0),
-                             line.substr(idx0 + 1, idx1 - idx0 - 1),
-                             (size_t)stoi(line.substr(idx1 + 1)));
-    } else {
-        *pout++ = make_tuple(line.substr(idx0 + 1, idx1 - idx0 - 1),
-                             line.substr(0, idx0),
-                             (size_t)stoi(line.substr(idx1 + 1)));
-    }
+  algorithm algo = opts.algo;
+  size_t max_k = opts.max_k;
+  bool utf8 = opts.utf8;
+  if (opts.batch) {
+    return test_query(p0, p1, inf, max_k, ws, verb);
+  } else if (opts.edits) {
+    return test_edit_script(p0, p1, inf, utf8, ws, verb);
+  } else if (opts.costs) {
+    return test_weighted(p0, p1, inf, *opts.costs, utf8, ws, verb);
+  } else if (xout) {
+    return test_variants(p0, p1, inf, max_k, dl::variant_of(algo), utf8, ws,
+                         *xout, verb);
+  } else if (algorithm::lw == algo) {
+    return test_lowrance_wagner(p0, p1, inf, max_k, filters, utf8, ws,
+                                tile_threads, verb);
+  } else if (algorithm::uk == algo) {
+    return test_ukkonen(p0, p1, inf, max_k, filters, utf8, ws, verb);
+  } else if (algorithm::bp == algo) {
+    return test_hyyro(p0, p1, inf, max_k, filters, utf8, ws, verb);
+  } else {
+    return test_berghel_roach(p0, p1, inf, max_k, filters, utf8, ws, verb);
   }
-
 }
 
 /**
@@ -128,31 +188,10 @@ read_corpus(const std::filesystem::path &pth, FOI pout)
  * correctness & possibly timing
  *
  *
- * \param algo [in] The algorithm to be exercised
- *
- * \param verbose [in] If true, produce verbose status messages on stdout; this
- * is intended for debugging & trouble-shooting; turning this feature on with a
- * large corpus of test data will likely be unhelpful
- *
- * \param randomize [in] If true, randomize the order of traversal through the
- * corpus of test data; specify this on successive runs to defeat any sort of
- * branch prediction, cache warming or other black magic going on that could
- * affect test timings
- *
- * \param num_loops [in] The number of times to go over the corpus; to get
- * reliable timings over a small set of test cases, you might want to set this
- * to a large number & set \a randomize to true. The test cases will be shuffled
- * before each iteration, and the time spent shuffling will not be included in
- * the reported timings
- *
- * \param print_timings [in] If true, print the time, in milliseconds on the
- * system clock, spent going over the test cases, exclusive of any shuffling
- * that may have been done. If you have a large test corpus, you may instead
- * just run this with \a num_loops = 1, \a randomize false, and just run the
- * program under `time'
+ * \param opts [in] How the corpus is to be gone over (see corpus_options)
  *
  * \param pcorp0 [in] A forward input iterator pointing to the beginning of a
- * range of paths naming ASCII text files containing test cases (see read_corpus
+ * range of paths naming text files containing test cases (see read_corpus
  * for details on their format)
  *
  * \param pcorp1 [in] A forward input iterator pointing to the one-past-the-end
@@ -163,13 +202,9 @@ read_corpus(const std::filesystem::path &pth, FOI pout)
 
 template <typename FII> // Forward Input Iterator
 bool
-dl(algorithm algo,
-   bool      verbose,
-   bool      randomize,
-   size_t    num_loops,
-   bool      print_timings,
-   FII       pcorp0,
-   FII       pcorp1)
+dl_main(const corpus_options &opts,
+        FII       pcorp0,
+        FII       pcorp1)
 {
   using namespace std;
 
@@ -178,8 +213,14 @@ dl(algorithm algo,
 
   using chrono::duration_cast;
 
+  // The test cases are views into the corpus files, which must stay mapped
+  // until we're done with them
+  vector<corpus_file> F;
+  for_each(pcorp0, pcorp1, [&](char *p) { F.emplace_back(p); });
   vector<test_case> C;
-  for_each(pcorp0, pcorp1, [&](char *p) { read_corpus(p, back_inserter(C)); });
+  for (const corpus_file &f: F) {
+    read_corpus(f, back_inserter(C));
+  }
 
   size_t inf = 0;
   for_each(C.begin(),
@@ -191,48 +232,150 @@ dl(algorithm algo,
              if (m > inf) inf = m;
            });
 
-  if (verbose) {
+  if (opts.verbose) {
     cout << "Testing over a corpus of " << C.size() << " string pairs " <<
       "(max length " << inf << ")." << endl;
   }
 
   chrono::steady_clock clock;
-  duration total_time;
+  duration total_time = duration::zero();
+
+  // In wavefront mode, the threads work on one comparison at a time
+  unsigned num_threads = opts.num_threads, tile_threads = 1;
+  if (opts.wavefront) {
+    tile_threads = num_threads;
+    num_threads = 1;
+  }
+
+  // Each worker thread gets its own workspace...
+  vector<dl::workspace> W(num_threads);
+  // (& its own tallies for the pre-filters & of the work done in it)
+  vector<dl::filter_stats> FS(num_threads);
+  vector<dl::work_stats> WS(num_threads);
+  unique_ptr<perf_counters> PC;
+  if (opts.print_timings) {
+    for (unsigned w = 0; w < num_threads; ++w) {
+      W[w].count_work(&WS[w]);
+    }
+    // The counters are opened before any worker threads are started, so as
+    // to count them, too
+    PC.reset(new perf_counters);
+  }
+  // & the corpus is handed out to them in chunks. They should be small enough
+  // that there are plenty to steal, but not so small that workers spend their
+  // time contending for them.
+  size_t chunk =
+    max<size_t>(1, min<size_t>(1024, C.size() / (8 * num_threads)));
+  size_t num_chunks = (C.size() + chunk - 1) / chunk;
 
   random_device rd;
   mt19937 g(rd());
 
   bool ok = true;
-  for (int i = 0; i < num_loops; ++i) {
+  for (int i = 0; i < opts.num_loops; ++i) {
 
-    if (randomize) {
+    if (opts.randomize) {
       shuffle(C.begin(), C.end(), g);
     }
 
+    vector<char> chunk_ok(num_chunks, 1);
+    bool keep_output = opts.verbose || opts.cross_check;
+    vector<ostringstream> chunk_out(keep_output ? num_chunks : 0);
+    // A single thread would stop at the first failure; chunks beyond the
+    // first failed chunk can't affect the output, so don't bother with them.
+    atomic<size_t> first_bad(num_chunks);
+
     auto then = clock.now();
+    if (PC) PC->start();
 
-    if (algorithm::lw == algo) {
-      if (!test_lowrance_wagner(C.begin(), C.end(), inf, verbose)) {
-        ok = false;
-      }
-    } else if (algorithm::uk == algo) {
-      if (!test_ukkonen(C.begin(), C.end(), inf, verbose)) {
-        ok = false;
+    dl::parallel_for(C.size(),
+                     chunk,
+                     num_threads,
+                     [&](unsigned w, size_t c, size_t i0, size_t i1) {
+                       if (c > first_bad.load(memory_order_relaxed)) return;
+                       ostream *verb = opts.verbose ? &chunk_out[c] : nullptr;
+                       ostream *xout =
+                         opts.cross_check ? &chunk_out[c] : nullptr;
+                       if (!test_range(opts, xout, C.begin() + i0,
+                                       C.begin() + i1, inf,
+                                       opts.prefilter ? &FS[w] : nullptr,
+                                       W[w], tile_threads, verb)) {
+                         chunk_ok[c] = 0;
+                         size_t bad = first_bad.load();
+                         while (c < bad &&
+                                !first_bad.compare_exchange_weak(bad, c));
+                       }
+                     });
+
+    if (PC) PC->stop();
+    auto now = clock.now();
+    total_time += now - then;
+
+    for (size_t c = 0; c < num_chunks; ++c) {
+      if (keep_output) {
+        cout << chunk_out[c].str();
       }
-    }
-    else {
-      if (!test_berghel_roach(C.begin(), C.end(), inf, verbose)) {
+      if (!chunk_ok[c]) {
         ok = false;
+        break;
       }
     }
+  }
 
-    auto now = clock.now();
-    total_time += now - then;
+  if (opts.prefilter) {
+    dl::filter_stats fs;
+    for (const dl::filter_stats &x: FS) {
+      fs += x;
+    }
+    size_t total = fs.equal + fs.length + fs.affix + fs.histogram + fs.bounds +
+      fs.dp;
+    cout << "prefilter settled " << total - fs.dp << " of " << total <<
+      " comparisons: " << fs.equal << " equal, " << fs.length << " length, " <<
+      fs.affix << " affix, " << fs.histogram << " histogram, " << fs.bounds <<
+      " bounds (" << fs.dp << " reached the algorithm)" << endl;
   }
 
-  if (print_timings) {
+  if (opts.print_timings) {
     ms msecs = duration_cast<ms>(total_time);
     cout << "processing took " << msecs.count() << "ms" << endl;
+
+    auto per = [](double x, size_t n) { return 0 == n ? 0. : x / n; };
+
+    // The algorithm's work is reported per comparison (the pre-filter may
+    // settle some pairs without one, & some variants take two)...
+    dl::work_stats work;
+    for (const dl::work_stats &x: WS) {
+      work += x;
+    }
+    size_t num_pairs = C.size() * opts.num_loops, n = work.comparisons;
+    cout << num_pairs << " pairs, " << n << " comparisons: " << work.cells <<
+      " cells, " << work.diagonals << " diagonals & " << work.slides <<
+      " slides (" << per(work.cells, n) << ", " << per(work.diagonals, n) <<
+      " & " << per(work.slides, n) << " per comparison)" << endl;
+
+    // while the counters, which see everything done in the interval, are
+    // reported per pair.
+    for (int i = 0; i < perf_counters::NUM_EVENTS; ++i) {
+      perf_counters::event e = (perf_counters::event)i;
+      cout << perf_counters::name(e) << ": ";
+      if (!PC->available(e)) {
+        cout << "unavailable (" << PC->why_not(e) << ")" << endl;
+        continue;
+      }
+      uint64_t x = PC->value(e);
+      if (perf_counters::task_clock == e) {
+        cout << x / 1000000 << "ms";
+      } else {
+        cout << x << " (" << per(x, num_pairs) << " per pair";
+        if (perf_counters::instructions == e &&
+            PC->available(perf_counters::cycles)) {
+          cout << ", " << per(x, PC->value(perf_counters::cycles)) <<
+            " per cycle";
+        }
+        cout << ")";
+      }
+      cout << endl;
+    }
   }
 
   return ok;
@@ -244,41 +387,161 @@ The Damerau-Levenshtein distance between two strings is the minimum number of
 insertions, deletions, single-character substitutions or transpositions
 required to transform the first string to the second. This program is a test
 harness that will compute this quantity for a corpus of strings in one of
-three ways:
+four ways:
 
     1. that of Lowrance & Wagner in "An Extension of the String-to-String
        Correction Problem" (1975)
     2. that of Ukkonen in "Algorithms for Approximate String Matching" (1985)
     3. that of Berghel & Roach in "An Extension of Ukkonen's Enhanced Dynamic
        Programming ASM Algoirthm" (1996)
+    4. that of Hyyrö in "A Bit-Vector Algorithm for Computing Levenshtein and
+       Damerau Edit Distances" (2002)
 
 Berghel & Roach remains, as far as I am aware, the optimal solution to this
-problem (later work has focused on defining different, easier-to-compute
-distance metrics).
+problem in terms of the number of cells of the recurrence relation computed
+(later work has focused on defining different, easier-to-compute distance
+metrics). Hyyrö instead computes entire columns of it at once using
+bit-vectors, which is hard to beat for short strings.
 
 Usage: dl [OPTION...] CORPUS...
+       dl --stream [OPTION...] [CORPUS...]
+       dl --dictionary=DICT -k K [OPTION...] [QUERIES...]
+       dl --dictionary=DICT --nearest=N [OPTION...] [QUERIES...]
+       dl build-index [OPTION...] DICT INDEX
+       dl query -k K [OPTION...] INDEX [QUERIES...]
+       dl gen [OPTION...] [COUNT]
+
+The first four forms are described under the options below. The
+`build-index' command indexes the words in DICT (as --dictionary would,
+honoring -i, -j, -k, -t & -u) & saves the index to the file INDEX; the
+`query' command loads that file & searches it for each line of QUERIES... (as
+--dictionary would, honoring -c & -t). Loading takes the same time however
+large the index, since the file is mapped into memory & used as-is, & several
+processes querying the same file share its pages. A deletion index must be
+given -k to build-index, & may then be queried for distances up to that K.
+
+The `gen' command makes COUNT (by default, 16) synthetic pairs of strings
+in memory & writes each, with the distance computed by -a (honoring -j, -k
+& -t), as a line of a CORPUS, as admin/make-dl-test-data would. The first
+string of each pair is drawn at random; the second is made from it by a
+number of random insertions, deletions, substitutions & transpositions
+(see -A, -E, -L & -S); the pairs made depend only on those, not on -j.
+With -q, nothing is written but the number of pairs & their mean distance,
+so that an algorithm may be timed over any number of pairs without I/O.
 
 where OPTION is one of:
 
          -h, --help: display this usage message & exit with status zero
       -V, --version: display this program's version & exit with status zero
+-A N, --alphabet=N:  with gen, draw the strings from an alphabet of N
+                     characters, from one to 94 (the default is 26, the
+                     letters A to Z)
 -a A, --algorithm=A: select the algorithm to apply to CORPUS...
                      A may be one of the following:
 
                      lw: Lowrance & Wagner
                      uk: Ukkonen
                      br: Berghel & Roach (default)
+                     bp: Hyyrö (bit-parallel)
 
+        -b, --batch: treat each run of lines sharing the same A as a single
+                     one-vs-many comparison, pre-processing A once (requires
+                     -a bp)
+        -c, --check: with `query', verify the index's checksum before
+                     searching it (this reads the entire file)
+-d DICT, --dictionary=DICT: rather than checking CORPUS..., index the
+                     words in DICT (one per line) & print each that is
+                     within K (which must be given, unless -N is) of each
+                     line of QUERIES... (`-' being stdin, the default) as
+                     "query<TAB>word<TAB>distance", closest first. Distances
+                     are unrestricted Damerau-Levenshtein distances, whatever
+                     -a says (but see -i del). With -t, report the work
+                     done on stderr. May not be combined with -b, -n, -r or
+                     -s
+-E N, --num-edits=N: with gen, make between one & N edits to the first
+                     string of each pair (the default is four); N may also
+                     be given as MIN-MAX
+   -e, --edit-script: with -a lw, recover an optimal edit script for each
+                     pair (by divide & conquer, in linear space), check that
+                     it turns A into B at a cost of D, & with -v, print it
+                     as a list of OPa/b (i: insert B[b] ahead of A[a], e:
+                     erase A[a], s: substitute B[b] for A[a], t: transpose
+                     A[a]); may not be combined with -b, -d, -f, -k, -s or
+                     -w
+    -f, --prefilter: before running the algorithm on each pair, try to settle
+                     it with a cascade of cheap tests (equality, length,
+                     common affixes, character histograms, bounds) &
+                     report how many pairs each settled; may not be combined
+                     with -b, -d or -s, nor given to build-index or query
+-i I, --index=I:     select the index in which --dictionary (or
+                     build-index) holds DICT; I may be one of the following:
+
+                     bk: a BK-tree, which compares the query against a
+                         fraction of the words (default)
+                     trie: a trie, which shares the work of comparing the
+                         query against words with a common prefix
+                     del: a deletion index, which finds candidates by
+                         hashing every way of deleting up to K characters
+                         from each word (practical for K of one or two;
+                         built on -j threads); its distances are
+                         restricted, as computed by Berghel & Roach
+
+-L N, --length=N:    with gen, make the first string of each pair N
+                     characters long (the default is five)
+-k K, --max-distance=K: only compute distances up to K; pairs further apart
+                     than that will be reported as K + 1 (and are expected
+                     to be)
+-j N, --threads=N:   spread the corpus over N threads; give zero to use one
+                     thread per CPU (the default is one thread). The output
+                     is the same regardless of N
+-N N, --nearest=N:   with --dictionary, rather than index DICT, scan it for
+                     the N words nearest each query (or fewer, if -k is
+                     given & fewer are within K), using Berghel & Roach
+                     bounded by the distance of the Nth best so far; the
+                     distances are therefore restricted. With -j, the
+                     words are spread over threads for each query. May not
+                     be combined with -i
 -n N, --num-loops=N: run the corpus N times (for benchmarking purposes)
+         -q, --quiet: with gen, write only a summary, not the pairs
     -r, --randomize: run the corpus in random order
+-S N, --seed=N:      with gen, seed the pair generator with N (the default
+                     is one)
+       -s, --stream: rather than loading each CORPUS before computing
+                     anything, compute distances as the input is read &
+                     write each pair, with its computed distance, to stdout
+                     as soon as it's known (in input order); the known
+                     distance may be omitted from each line, & a CORPUS of
+                     `-' (the default) is read from stdin. Memory use does
+                     not grow with the size of the input. May not be
+                     combined with -b, -n or -r
 -t, --print-timings: print timings on the command line; one could invoke this
                      program using `time' for benchmarking purposes, but this
                      option will exclude time spent reading & parsing the
-                     input files
+                     input files; along with the time, report the work done
+                     by the algorithm (cells, diagonals & slides) & the
+                     CPU's performance counters, where they're available
+         -u, --utf8: take A & B to be UTF-8 & compare the characters they
+                     encode, rather than their bytes (ill-formed sequences
+                     are taken as U+FFFD); may not be combined with -b
       -v, --verbose: provide verbose output on the computation; this is
                      intended for debugging purposes; supplying this option
                      with a large corpus of input strings will likely
                      be un-helpful
+-W FILE, --weights=FILE: with -a lw, weigh each edit by the costs given in
+                     FILE (see below), & compare the weighted distances to
+                     D; may not be combined with -b, -d, -e, -f, -k, -s or
+                     -w
+    -w, --wavefront: with -a lw, rather than spread the corpus over the -j
+                     threads, compare one pair at a time, spreading the
+                     tiles of each comparison over the threads (for a few
+                     very long pairs); may not be combined with -b, -d, -k
+                     or -s
+  -x, --cross-check: compute both the restricted distance (as uk, br & bp
+                     do) & the unrestricted distance (as lw does) for each
+                     pair, print each pair on which they disagree as
+                     "A<TAB>B<TAB>restricted<TAB>unrestricted", & compare
+                     whichever -a computes to D; may not be combined with
+                     -b, -d, -e, -f, -s, -W or -w
 
 and CORPUS is a path (absolute or relative to the present working directory)
 of a plain text file containing one or more lines of three tab-delimited
@@ -288,7 +551,17 @@ fields:
 
 where A & B are two strings to be compared & D is their (previously computed)
 Damerau-Levenshtein distance. This program will exit with status zero if it
-computes the same value as D for all (A,B), and 1 if any differ.
+computes the same value as D for all (A,B), and 1 if any differ (in --stream
+mode, such pairs are marked with a fourth field).
+
+The FILE given to --weights holds lines of the form
+
+    insertion|deletion|substitution|transposition [a b] COST
+
+each setting the cost of every edit of that kind (one, by default) or, for
+substitutions & transpositions, of that edit between two given characters
+(single bytes); a transposition of a & b turns "ab" into "ba". Since the
+shorter of A & B is always taken as A, the costs should be symmetric.
 
 Please see %s for more discussion & links to these papers.
 )use";
@@ -298,76 +571,477 @@ main(int argc, char **argv)
 {
   static struct option long_options[] = {
     {"algorithm",     required_argument, 0, 'a'},
+    {"alphabet",      required_argument, 0, 'A'},
+    {"batch",         no_argument,       0, 'b'},
+    {"check",         no_argument,       0, 'c'},
+    {"dictionary",    required_argument, 0, 'd'},
+    {"edit-script",   no_argument,       0, 'e'},
     {"help",          no_argument,       0, 'h'},
+    {"prefilter",     no_argument,       0, 'f'},
+    {"index",         required_argument, 0, 'i'},
+    {"length",        required_argument, 0, 'L'},
+    {"max-distance",  required_argument, 0, 'k'},
+    {"nearest",       required_argument, 0, 'N'},
+    {"num-edits",     required_argument, 0, 'E'},
     {"num-loops",     required_argument, 0, 'n'},
     {"print-timings", no_argument,       0, 't'},
+    {"quiet",         no_argument,       0, 'q'},
     {"randomize",     no_argument,       0, 'r'},
+    {"seed",          required_argument, 0, 'S'},
+    {"stream",        no_argument,       0, 's'},
+    {"threads",       required_argument, 0, 'j'},
+    {"utf8",          no_argument,       0, 'u'},
     {"verbose",       no_argument,       0, 'v'},
     {"version",       no_argument,       0, 'V'},
+    {"wavefront",     no_argument,       0, 'w'},
+    {"weights",       required_argument, 0, 'W'},
+    {"cross-check",   no_argument,       0, 'x'},
     {0, 0, 0, 0}
   };
 
-  auto algo = algorithm::br;
-  bool print_timings = false, randomize = false, verbose = false;
-  size_t num_loops = 1;
+  // The sub-commands precede any options
+  enum class command { none, build_index, query, gen } cmd = command::none;
+  if (1 < argc && 0 == strcmp(argv[1], "build-index")) {
+    cmd = command::build_index;
+  } else if (1 < argc && 0 == strcmp(argv[1], "query")) {
+    cmd = command::query;
+  } else if (1 < argc && 0 == strcmp(argv[1], "gen")) {
+    cmd = command::gen;
+  }
+  if (command::none != cmd) {
+    argv[1] = argv[0];
+    ++argv;
+    --argc;
+  }
+
+  corpus_options opts;
+  bool check = false, stream = false, quiet = false;
+  dl::synth_params synth;
+  bool synth_given = false;
+  std::uint64_t seed = 1;
+  const char *weights = nullptr;
+  size_t nearest = 0;
+  const char *dict = nullptr;
+  auto index = dictionary_index::bk_tree;
+  bool index_given = false;
   int c, option_index = 0;
   while (1) {
-    c = getopt_long(argc, argv, "a:hn:prtvV", long_options, &option_index);
+    c = getopt_long(argc, argv, "A:a:bcd:E:efhi:j:k:L:N:n:pqrS:stuvVwW:x",
+                    long_options, &option_index);
     if (-1 == c) break;
     switch (c) {
+    case 'A': {
+      char *end;
+      synth_given = true;
+      synth.alphabet = strtoul(optarg, &end, 10);
+      if (optarg == end || *end || 0 == synth.alphabet ||
+          94 < synth.alphabet) {
+        fprintf(stderr, "can't interpret `%s' as an alphabet size-- try "
+                "`dl --help'\n", optarg);
+        exit(2);
+      }
+      break;
+    }
     case 'a':
       if (0 == strcmp(optarg, "lw")) {
-        algo = algorithm::lw;
+        opts.algo = algorithm::lw;
       } else if (0 == strcmp(optarg, "uk")) {
-        algo = algorithm::uk;
+        opts.algo = algorithm::uk;
+      } else if (0 == strcmp(optarg, "bp")) {
+        opts.algo = algorithm::bp;
       } else if (0 != strcmp(optarg, "br")) {
         fprintf(stderr, "unknown algorithm `%s' -- try `dl --help'", optarg);
         exit(2);
       }
       break;
+    case 'b':
+      opts.batch = true;
+      break;
+    case 'c':
+      check = true;
+      break;
+    case 'd':
+      dict = optarg;
+      break;
+    case 'E': {
+      char *end;
+      synth_given = true;
+      synth.min_edits = synth.max_edits = strtoul(optarg, &end, 10);
+      if (optarg != end && '-' == *end) {
+        const char *p = end + 1;
+        synth.max_edits = strtoul(p, &end, 10);
+        if (p == end) end = (char*)optarg;
+      } else {
+        synth.min_edits = 1;
+      }
+      if (optarg == end || *end || synth.min_edits > synth.max_edits) {
+        fprintf(stderr, "can't interpret `%s' as # of edits-- try "
+                "`dl --help'\n", optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 'e':
+      opts.edits = true;
+      break;
+    case 'f':
+      opts.prefilter = true;
+      break;
     case 'h':
       printf(USAGE, argv[0], PACKAGE_URL);
       exit(0);
+    case 'i':
+      index_given = true;
+      if (0 == strcmp(optarg, "trie")) {
+        index = dictionary_index::trie;
+      } else if (0 == strcmp(optarg, "del")) {
+        index = dictionary_index::deletion;
+      } else if (0 != strcmp(optarg, "bk")) {
+        fprintf(stderr, "unknown index `%s' -- try `dl --help'", optarg);
+        exit(2);
+      }
+      break;
+    case 'j': {
+      char *end;
+      opts.num_threads = strtoul(optarg, &end, 10);
+      if (optarg == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as # of threads-- try "
+                "`dl --help'", optarg);
+        exit(2);
+      }
+      if (0 == opts.num_threads) {
+        opts.num_threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      break;
+    }
+    case 'k': {
+      char *end;
+      opts.max_k = strtoul(optarg, &end, 10);
+      if (optarg == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as a distance-- try `dl --help'",
+                optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 'L': {
+      char *end;
+      synth_given = true;
+      synth.length = strtoul(optarg, &end, 10);
+      if (optarg == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as a length-- try `dl --help'\n",
+                optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 'N': {
+      char *end;
+      nearest = strtoul(optarg, &end, 10);
+      if (optarg == end || *end || 0 == nearest) {
+        fprintf(stderr, "can't interpret `%s' as # of matches-- try "
+                "`dl --help'", optarg);
+        exit(2);
+      }
+      break;
+    }
     case 'n':
-      num_loops = atoi(optarg);
-      if (0 == num_loops) {
+      opts.num_loops = atoi(optarg);
+      if (0 == opts.num_loops) {
         fprintf(stderr, "can't interpret `%s' as # of loops-- try `dl --help'",
                 optarg);
         exit(2);
       }
       break;
     case 'p':
-      print_timings = true;
+      opts.print_timings = true;
+      break;
+    case 'q':
+      quiet = synth_given = true;
       break;
     case 'r':
-      randomize = true;
+      opts.randomize = true;
+      break;
+    case 'S': {
+      char *end;
+      synth_given = true;
+      seed = strtoull(optarg, &end, 10);
+      if (optarg == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as a seed-- try `dl --help'\n",
+                optarg);
+        exit(2);
+      }
+      break;
+    }
+    case 's':
+      stream = true;
       break;
     case 't':
-      print_timings = true;
+      opts.print_timings = true;
+      break;
+    case 'u':
+      opts.utf8 = true;
       break;
     case 'v':
-      verbose = true;
+      opts.verbose = true;
       break;
     case 'V':
       printf("`%s' %s\n", argv[0], PACKAGE_VERSION);
       exit(0);
+    case 'w':
+      opts.wavefront = true;
+      break;
+    case 'W':
+      weights = optarg;
+      break;
+    case 'x':
+      opts.cross_check = true;
+      break;
     case '?':
       /* getopt_long has already printed an error message */
       exit(2);
     }
   }
 
+  if (nearest && (!dict || index_given)) {
+    fprintf(stderr, "--nearest requires --dictionary & may not be combined "
+            "with -i-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (opts.wavefront && (algorithm::lw != opts.algo || opts.batch || dict ||
+                         stream || command::none != cmd ||
+                         NO_MAX_K != opts.max_k)) {
+    fprintf(stderr, "--wavefront requires `-a lw' & may not be combined with "
+            "-b, -d, -k or -s-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (opts.edits && (algorithm::lw != opts.algo || opts.batch || dict ||
+                     opts.prefilter || stream || opts.wavefront ||
+                     command::none != cmd || NO_MAX_K != opts.max_k)) {
+    fprintf(stderr, "--edit-script requires `-a lw' & may not be combined "
+            "with -b, -d, -f, -k, -s or -w-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (weights && (algorithm::lw != opts.algo || opts.batch || dict ||
+                  opts.edits || opts.prefilter || stream || opts.wavefront ||
+                  command::none != cmd || NO_MAX_K != opts.max_k)) {
+    fprintf(stderr, "--weights requires `-a lw' & may not be combined with "
+            "-b, -d, -e, -f, -k, -s or -w-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (opts.cross_check && (opts.batch || dict || opts.edits ||
+                           opts.prefilter || stream || opts.wavefront ||
+                           weights || command::none != cmd)) {
+    fprintf(stderr, "--cross-check may not be combined with -b, -d, -e, -f, "
+            "-s, -W or -w-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (synth_given && command::gen != cmd) {
+    fprintf(stderr, "-A, -E, -L, -q & -S may only be given to gen-- try "
+            "`dl --help'\n");
+    exit(2);
+  }
+
+  if (index_given && !dict && command::build_index != cmd) {
+    fprintf(stderr, "--index may only be given with --dictionary or to "
+            "build-index-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (check && command::query != cmd) {
+    fprintf(stderr, "--check may only be given to query-- try `dl --help'\n");
+    exit(2);
+  }
+
+  if (command::gen == cmd) {
+    if (opts.batch || dict || opts.edits || opts.prefilter || opts.randomize ||
+        stream || opts.utf8 || opts.wavefront || weights || opts.cross_check ||
+        1 != opts.num_loops) {
+      fprintf(stderr, "gen may not be combined with -b, -d, -e, -f, -n, -r, "
+              "-s, -u, -W, -w or -x-- try `dl --help'\n");
+      exit(2);
+    }
+    std::size_t count = 16;
+    if (1 < argc - optind) {
+      fprintf(stderr, "gen takes at most one argument-- try `dl --help'\n");
+      exit(2);
+    }
+    if (optind < argc) {
+      char *end;
+      count = strtoul(argv[optind], &end, 10);
+      if (argv[optind] == end || *end) {
+        fprintf(stderr, "can't interpret `%s' as # of pairs-- try "
+                "`dl --help'\n", argv[optind]);
+        exit(2);
+      }
+    }
+    try {
+      generate_corpus(synth, seed, count, opts.algo, opts.max_k, quiet,
+                      opts.num_threads, opts.print_timings, std::cout);
+    } catch (const std::exception &ex) {
+      fprintf(stderr, "%s\n", ex.what());
+      return 127;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (command::build_index == cmd) {
+    if (dict || opts.batch || opts.prefilter || opts.randomize || stream ||
+        1 != opts.num_loops) {
+      fprintf(stderr, "build-index may not be combined with -b, -d, -f, -n, -r "
+              "or -s-- try `dl --help'\n");
+      exit(2);
+    }
+    if (2 != argc - optind) {
+      fprintf(stderr, "build-index takes a dictionary & an index-- try "
+              "`dl --help'\n");
+      exit(2);
+    }
+    if (dictionary_index::deletion == index && NO_MAX_K == opts.max_k) {
+      fprintf(stderr, "a deletion index requires --max-distance-- try "
+              "`dl --help'\n");
+      exit(2);
+    }
+    try {
+      build_index(argv[optind], index, opts.max_k, opts.utf8, opts.num_threads,
+                  opts.print_timings, argv[optind + 1]);
+    } catch (const std::exception &ex) {
+      fprintf(stderr, "%s\n", ex.what());
+      return 127;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (command::query == cmd) {
+    if (dict || opts.batch || opts.prefilter || opts.randomize || stream ||
+        1 != opts.num_loops) {
+      fprintf(stderr, "query may not be combined with -b, -d, -f, -n, -r or "
+              "-s-- try `dl --help'\n");
+      exit(2);
+    }
+    if (NO_MAX_K == opts.max_k) {
+      fprintf(stderr, "query requires --max-distance-- try `dl --help'\n");
+      exit(2);
+    }
+    if (optind == argc) {
+      fprintf(stderr, "you didn't specify an index-- try `dl --help'\n");
+      exit(2);
+    }
+    std::vector<std::string> paths(argv + optind + 1, argv + argc);
+    if (paths.empty()) {
+      paths.push_back("-");
+    }
+    try {
+      query_index(argv[optind], opts.max_k, check, opts.print_timings, paths,
+                  std::cout);
+    } catch (const std::exception &ex) {
+      fprintf(stderr, "%s\n", ex.what());
+      return 127;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (dict) {
+    if (opts.batch || opts.prefilter || opts.randomize || stream ||
+        1 != opts.num_loops) {
+      fprintf(stderr, "--dictionary may not be combined with -b, -f, -n, -r or "
+              "-s-- try `dl --help'\n");
+      exit(2);
+    }
+    if (NO_MAX_K == opts.max_k && !nearest) {
+      fprintf(stderr, "--dictionary requires --max-distance or --nearest-- "
+              "try `dl --help'\n");
+      exit(2);
+    }
+    std::vector<std::string> paths(argv + optind, argv + argc);
+    if (paths.empty()) {
+      paths.push_back("-");
+    }
+    try {
+      if (nearest) {
+        nearest_in_dictionary(dict, nearest, opts.max_k, opts.utf8,
+                              opts.num_threads, opts.print_timings, paths,
+                              std::cout);
+      } else {
+        search_dictionary(dict, index, opts.max_k, opts.utf8, opts.num_threads,
+                          opts.print_timings, paths, std::cout);
+      }
+    } catch (const std::exception &ex) {
+      fprintf(stderr, "%s\n", ex.what());
+      return 127;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (stream) {
+    if (opts.batch || opts.prefilter || opts.randomize || 1 != opts.num_loops) {
+      fprintf(stderr, "--stream may not be combined with -b, -f, -n or -r-- "
+              "try `dl --help'\n");
+      exit(2);
+    }
+    std::vector<std::string> paths(argv + optind, argv + argc);
+    if (paths.empty()) {
+      paths.push_back("-");
+    }
+    int status = EXIT_SUCCESS;
+    try {
+      auto then = std::chrono::steady_clock::now();
+      if (!stream_corpus(opts.algo, opts.max_k, opts.utf8, opts.num_threads,
+                         paths, std::cout)) {
+        status = EXIT_FAILURE;
+      }
+      if (opts.print_timings) {
+        auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - then);
+        fprintf(stderr, "processing took %ldms\n", (long) msecs.count());
+      }
+    } catch (const std::exception &ex) {
+      fprintf(stderr, "%s\n", ex.what());
+      status = 127;
+    }
+    return status;
+  }
+
   if (optind == argc) {
     fprintf(stderr, "you didn't specify a corpus-- try `dl--help'\n");
     exit(2);
   }
 
-  if (verbose) {
-    printf("algo is %d\n", (int) algo);
-    printf("verbose is %d\n", verbose ? 1 : 0);
-    printf("num-loops is %lu\n", num_loops);
-    printf("randomize is %d\n", randomize ? 1 : 0);
-    printf("print-timings is %d\n", print_timings ? 1 : 0);
+  if (opts.batch && algorithm::bp != opts.algo) {
+    fprintf(stderr, "--batch requires `-a bp'-- try `dl --help'\n");
+    exit(2);
+  }
+  if (opts.batch && opts.prefilter) {
+    fprintf(stderr, "--batch may not be combined with --prefilter-- try "
+            "`dl --help'\n");
+    exit(2);
+  }
+  if (opts.batch && opts.utf8) {
+    fprintf(stderr, "--batch may not be combined with --utf8-- try "
+            "`dl --help'\n");
+    exit(2);
+  }
+
+  if (opts.verbose) {
+    printf("algo is %d\n", (int) opts.algo);
+    printf("batch is %d\n", opts.batch ? 1 : 0);
+    printf("edit-script is %d\n", opts.edits ? 1 : 0);
+    printf("verbose is %d\n", opts.verbose ? 1 : 0);
+    printf("num-loops is %lu\n", opts.num_loops);
+    printf("max-distance is %lu\n", opts.max_k);
+    printf("prefilter is %d\n", opts.prefilter ? 1 : 0);
+    printf("utf8 is %d\n", opts.utf8 ? 1 : 0);
+    printf("randomize is %d\n", opts.randomize ? 1 : 0);
+    printf("threads is %u\n", opts.num_threads);
+    printf("wavefront is %d\n", opts.wavefront ? 1 : 0);
+    printf("weights: %s\n", weights ? weights : "(none)");
+    printf("cross-check is %d\n", opts.cross_check ? 1 : 0);
+    printf("print-timings is %d\n", opts.print_timings ? 1 : 0);
     for (int i = optind; i < argc; ++i) {
       printf("corpus: %s\n", argv[i]);
     }
@@ -375,8 +1049,12 @@ main(int argc, char **argv)
 
   int status = EXIT_SUCCESS;
   try {
-    if (!dl(algo, verbose, randomize, num_loops, print_timings, argv + optind,
-            argv + argc)) {
+    std::unique_ptr<dl::cost_table> costs;
+    if (weights) {
+      costs.reset(new dl::cost_table(read_costs(corpus_file(weights))));
+    }
+    opts.costs = costs.get();
+    if (!dl_main(opts, argv + optind, argv + argc)) {
       status = EXIT_FAILURE;
     }
   } catch (const std::exception &ex) {
@@ -0,0 +1,166 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "filter.hh"
+
+#include <algorithm>
+#include <cstddef>
+
+dl::filter_stats&
+dl::filter_stats::operator+=(const filter_stats &that)
+{
+  equal += that.equal;
+  length += that.length;
+  affix += that.affix;
+  histogram += that.histogram;
+  bounds += that.bounds;
+  dp += that.dp;
+  return *this;
+}
+
+namespace {
+
+  template <typename CharT>
+  bool
+  prefilter(std::basic_string_view<CharT> &A,
+            std::basic_string_view<CharT> &B,
+            std::size_t max_k,
+            std::size_t &d,
+            dl::filter_stats *stats)
+  {
+    using namespace std;
+
+    dl::filter_stats dummy;
+    dl::filter_stats &fs = stats ? *stats : dummy;
+
+    auto settle = [&](size_t x, size_t &counter) {
+      d = x > max_k ? max_k + 1 : x;
+      ++counter;
+      return true;
+    };
+
+    // 1. identical strings
+    if (A == B) {
+      return settle(0, fs.equal);
+    }
+
+    // 2. length difference
+    size_t m = A.length(), n = B.length();
+    size_t lb = m > n ? m - n : n - m;
+    if (lb > max_k) {
+      return settle(lb, fs.length);
+    }
+
+    // 3. common affixes
+    size_t pre = 0;
+    while (pre < m && pre < n && A[pre] == B[pre]) ++pre;
+    A.remove_prefix(pre);
+    B.remove_prefix(pre);
+    m -= pre;
+    n -= pre;
+    size_t suf = 0;
+    while (suf < m && suf < n && A[m - suf - 1] == B[n - suf - 1]) ++suf;
+    A.remove_suffix(suf);
+    B.remove_suffix(suf);
+    m -= suf;
+    n -= suf;
+    if (0 == m || 0 == n) {
+      return settle(m + n, fs.affix);
+    }
+
+    // 4. character histograms (which can only tell us something if the
+    // strings are long enough); the strings now differ in their first
+    // character, so they're at least one apart. Wider characters are binned by
+    // their low byte: merging bins can only shrink the bound, so it remains a
+    // lower bound.
+    if (max(m, n) > max_k) {
+      // Rather than clear all 256 entries, clear just those we'll look at
+      ptrdiff_t H[256];
+      for (CharT c: A) H[c & 0xff] = 0;
+      for (CharT c: B) H[c & 0xff] = 0;
+      for (CharT c: A) ++H[c & 0xff];
+      for (CharT c: B) --H[c & 0xff];
+      // The entries sum to m - n, so the total of the negative entries follows
+      // from that of the positive
+      size_t pos = 0;
+      for (CharT c: A) {
+        if (H[c & 0xff] > 0) {
+          pos += H[c & 0xff];
+          H[c & 0xff] = 0;
+        }
+      }
+      size_t neg = pos + n - m;
+      lb = max({lb, pos, neg});
+    }
+    lb = max(lb, size_t(1));
+    if (lb > max_k) {
+      return settle(lb, fs.histogram);
+    }
+
+    // 5. an upper bound for strings of equal length
+    if (m == n) {
+      size_t ub = 0;
+      for (size_t i = 0; i < m && ub <= max_k; ) {
+        if (A[i] == B[i]) {
+          ++i;
+        } else if (i + 1 < m && A[i] == B[i+1] && A[i+1] == B[i]) {
+          ++ub;
+          i += 2;
+        } else {
+          ++ub;
+          ++i;
+        }
+      }
+      if (ub == lb) {
+        return settle(ub, fs.bounds);
+      }
+    }
+
+    ++fs.dp;
+    return false;
+  }
+
+}
+
+bool
+dl::prefilter(std::string_view &A,
+              std::string_view &B,
+              std::size_t max_k,
+              std::size_t &d,
+              filter_stats *stats)
+{
+  return ::prefilter(A, B, max_k, d, stats);
+}
+
+bool
+dl::prefilter(std::u16string_view &A,
+              std::u16string_view &B,
+              std::size_t max_k,
+              std::size_t &d,
+              filter_stats *stats)
+{
+  return ::prefilter(A, B, max_k, d, stats);
+}
+
+bool
+dl::prefilter(std::u32string_view &A,
+              std::u32string_view &B,
+              std::size_t max_k,
+              std::size_t &d,
+              filter_stats *stats)
+{
+  return ::prefilter(A, B, max_k, d, stats);
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef FILTER_HH_INCLUDED
+#define FILTER_HH_INCLUDED 1
+
+#include <cstddef>
+#include <string_view>
+
+namespace dl {
+
+  /// The number of pairs settled at each stage of dl::prefilter (& the number
+  /// that weren't)
+  struct filter_stats {
+    /// The two strings were identical
+    std::size_t equal = 0;
+    /// Their lengths differed by more than the threshold
+    std::size_t length = 0;
+    /// Once their common prefix & suffix were removed, one was empty
+    std::size_t affix = 0;
+    /// Their character histograms differed by more than the threshold
+    std::size_t histogram = 0;
+    /// A cheap upper bound on the distance met the lower bound
+    std::size_t bounds = 0;
+    /// None of the above; the pair had to be handed to an algorithm
+    std::size_t dp = 0;
+
+    filter_stats& operator+=(const filter_stats &that);
+  };
+
+  /**
+   * \brief Attempt to settle a bounded comparison without running any of the
+   * algorithms
+   *
+   *
+   * \param A [in,out] the first of the two strings to be compared; if the
+   * comparison can't be settled, it will be narrowed to the portion that
+   * still needs to be compared
+   *
+   * \param B [in,out] the second of the two strings to be compared; narrowed
+   * along with \a A
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \param d [out] if the comparison was settled, the value that
+   * distance_within(A, B, max_k) would have returned
+   *
+   * \param stats [in,out] if non-null, the counter for the stage that settled
+   * the comparison (or stats->dp, if none did) will be incremented
+   *
+   * \return true if the comparison was settled, false if the (narrowed)
+   * strings must still be compared
+   *
+   *
+   * Applies a cascade of O(m+n) tests, cheapest first:
+   *
+   * 1. identical strings are zero apart
+   * 2. the distance is at least the difference in the lengths of the strings
+   * 3. a common prefix or suffix never changes the distance, so it is
+   *    stripped; if that leaves one string empty, the distance is the length
+   *    of the other
+   * 4. each edit changes the number of occurrences of at most one character
+   *    in either string (a transposition changes none), so the distance is at
+   *    least the larger of the number of characters in A for which B has no
+   *    counterpart & vice versa
+   * 5. if the strings are of equal length, comparing them position-by-position
+   *    (taking an adjacent transposition as a single edit) gives an upper bound
+   *    on the distance; if that meets the best lower bound, it is the distance
+   *
+   * Every test holds for both the restricted & the unrestricted distance.
+   *
+   * For 16- & 32-bit characters, the histogram of test 4 is kept by the low
+   * eight bits of each character; lumping characters together can only weaken
+   * the bound, never invalidate it.
+   *
+   *
+   */
+
+  bool
+  prefilter(std::string_view &A,
+            std::string_view &B,
+            std::size_t max_k,
+            std::size_t &d,
+            filter_stats *stats = nullptr);
+
+  /// As above, for strings of 16-bit characters
+  bool
+  prefilter(std::u16string_view &A,
+            std::u16string_view &B,
+            std::size_t max_k,
+            std::size_t &d,
+            filter_stats *stats = nullptr);
+
+  /// As above, for strings of 32-bit characters
+  bool
+  prefilter(std::u32string_view &A,
+            std::u32string_view &B,
+            std::size_t max_k,
+            std::size_t &d,
+            filter_stats *stats = nullptr);
+
+} // namespace dl
+
+#endif // FILTER_HH_INCLUDED
@@ -0,0 +1,109 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "gen.hh"
+#include "parallel.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+  /// Pairs are made & compared in chunks of this many, each from a stream of
+  /// the generator of its own
+  const std::size_t CHUNK_PAIRS = 4096;
+
+}
+
+void
+generate_corpus(const dl::synth_params &params,
+                std::uint64_t seed,
+                std::size_t count,
+                dl::algorithm algo,
+                std::size_t max_k,
+                bool quiet,
+                unsigned num_threads,
+                bool print_timings,
+                std::ostream &out)
+{
+  using namespace std;
+
+  typedef chrono::steady_clock clock_type;
+
+  const size_t NO_MAX_K = numeric_limits<size_t>::max();
+
+  // Check the parameters before starting any threads...
+  dl::pair_generator check(params, seed);
+
+  if (0 == num_threads) num_threads = 1;
+  size_t num_chunks = (count + CHUNK_PAIRS - 1) / CHUNK_PAIRS;
+  // & bound the output held at any one time to a round of chunks.
+  size_t round = 8 * num_threads;
+  vector<dl::workspace> W(num_threads - 1);
+  vector<string> text(quiet ? 0 : round);
+  vector<size_t> sums(round);
+
+  auto then = clock_type::now();
+  size_t total = 0;
+  for (size_t c0 = 0; c0 < num_chunks; c0 += round) {
+    size_t nc = min(round, num_chunks - c0);
+    dl::parallel_for(nc, 1, num_threads,
+                     [&](unsigned w, size_t, size_t i0, size_t i1) {
+      dl::workspace &ws = 0 == w ? dl::this_thread_workspace() : W[w - 1];
+      string A, B;
+      for (size_t i = i0; i < i1; ++i) {
+        size_t c = c0 + i;
+        size_t n = min(CHUNK_PAIRS, count - c*CHUNK_PAIRS);
+        dl::pair_generator gen(params, seed, c);
+        string *t = quiet ? nullptr : &text[i];
+        if (t) t->clear();
+        size_t sum = 0;
+        for (size_t j = 0; j < n; ++j) {
+          gen(A, B);
+          size_t d = NO_MAX_K == max_k ?
+            dl::distance(A, B, algo, ws) :
+            dl::distance_within(A, B, max_k, algo, ws);
+          sum += d;
+          if (t) {
+            t->append(A).append(1, '\t').append(B).append(1, '\t');
+            t->append(to_string(d)).append(1, '\n');
+          }
+        }
+        sums[i] = sum;
+      }
+    });
+    for (size_t i = 0; i < nc; ++i) {
+      total += sums[i];
+      if (!quiet) out << text[i];
+    }
+  }
+  out.flush();
+  double msecs = chrono::duration<double, milli>(clock_type::now() -
+                                                 then).count();
+
+  if (quiet) {
+    out << count << " pairs, mean distance " <<
+      (count ? double(total) / count : 0.0) << endl;
+  }
+  if (print_timings) {
+    cerr << "generating & comparing " << count << " pairs took " <<
+      (long) msecs << "ms (" << (long) (count / max(msecs, 1e-3) * 1e3) <<
+      " pairs/s)" << endl;
+  }
+}
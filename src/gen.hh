@@ -0,0 +1,78 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef GEN_HH_INCLUDED
+#define GEN_HH_INCLUDED 1
+
+#include "damlev.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * \brief Make synthetic pairs of strings & compute the distance between each
+ *
+ *
+ * \param params [in] The shape of the pairs to be made (see dl::synth_params)
+ *
+ * \param seed [in] The seed for the pair generator
+ *
+ * \param count [in] The number of pairs to be made
+ *
+ * \param algo [in] The algorithm with which to compute each distance
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param quiet [in] If true, write nothing but a summary (the number of pairs
+ * & their mean distance) to \a out
+ *
+ * \param num_threads [in] The number of threads over which to spread the
+ * work
+ *
+ * \param print_timings [in] If true, report the time taken on stderr
+ *
+ * \param out [in] The stream to which each pair shall be written, with its
+ * distance, as a line of a corpus
+ *
+ *
+ * This does the job of admin/make-dl-test-data without a Haskell toolchain:
+ * the pairs are made by dl::pair_generator in memory, so that nothing need be
+ * written out & parsed back in. With \a quiet, nothing is written at all, &
+ * the time taken (\a print_timings) is that of making & comparing the pairs
+ * alone; memory use doesn't grow with \a count, so billions of pairs may be
+ * run through an algorithm.
+ *
+ * The pairs are made in chunks, each by a generator with the same seed & a
+ * stream of its own, & the chunks are handed out to the threads a round at a
+ * time, their results being written in order at the end of each round. So
+ * the output depends on \a params, \a seed & \a count, but not on
+ * \a num_threads.
+ *
+ *
+ */
+
+void
+generate_corpus(const dl::synth_params &params,
+                std::uint64_t seed,
+                std::size_t count,
+                dl::algorithm algo,
+                std::size_t max_k,
+                bool quiet,
+                unsigned num_threads,
+                bool print_timings,
+                std::ostream &out);
+
+#endif // GEN_HH_INCLUDED
@@ -0,0 +1,772 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef HARNESS_HH_INCLUDED
+#define HARNESS_HH_INCLUDED 1
+
+#include "damlev.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/**
+ * \file harness.hh
+ *
+ * \brief Drive each of the library's algorithms over a corpus of test cases
+ *
+ *
+ * A "test case" is simply a three-tuple: string "A", string "B", and the known
+ * distance between them. IOW, the iterators taken by the functions in this
+ * file shall dereference to a test_case. The strings are views into the
+ * corpus, which must outlive them.
+ * I arrange for all D-L algorithms in this program to take a range of test
+ * cases (instead of a single test case) to enable them to take advantage any
+ * one-time initialization logic or other global optimizations which they may
+ * provide.
+ *
+ * Each is handed a workspace, in which every comparison in the range is made;
+ * when evaluating a corpus on several threads, each thread should have its
+ * own.
+ *
+ * Each takes a threshold \a max_k; if that is less than the known distance
+ * for a given test case, the algorithm is expected to give up & report
+ * \a max_k + 1 (see dl::distance_within).
+ *
+ *
+ */
+
+/// A test case for computing the edit distance between two strings: a three
+/// tuple consisting of string "A", string "B", and the known edit distance
+/// between them
+typedef std::tuple<std::string_view, std::string_view, std::size_t> test_case;
+
+/// Pass this as \a max_k to test the un-bounded version of each algorithm
+const std::size_t NO_MAX_K = std::numeric_limits<std::size_t>::max();
+
+/**
+ * \brief Check a computed distance against the known distance for a test case
+ *
+ *
+ * \param A [in] the first string in the test case
+ *
+ * \param B [in] the second string in the test case
+ *
+ * \param D [in] the known Damerau-Levenshtein distance between \a A & \a B
+ *
+ * \param max_k [in] the threshold given to the algorithm
+ *
+ * \param d [in] the distance computed by the algorithm
+ *
+ * \param verb [in] if non-null, the stream to which verbose progress messages
+ * shall be written
+ *
+ * \return true if \a d is correct, false else
+ *
+ *
+ */
+
+inline
+bool
+check_distance(std::string_view A,
+               std::string_view B,
+               std::size_t D,
+               std::size_t max_k,
+               std::size_t d,
+               std::ostream *verb)
+{
+  using namespace std;
+  size_t expected = D > max_k ? max_k + 1 : D;
+  if (verb) {
+    *verb << "Comparing '" << A << "' (" << A.length() << ") to '" << B <<
+      "' (" << B.length() << "); computed distance: " << d << endl;
+  }
+  return d == expected;
+}
+
+/**
+ * \brief Apply dl::prefilter to a test case, if asked
+ *
+ *
+ * \param A [in,out] the first string in the test case; narrowed to the
+ * portion still needing comparison if the test case isn't settled
+ *
+ * \param B [in,out] the second string in the test case; narrowed along with
+ * \a A
+ *
+ * \param max_k [in] the threshold given to the algorithm
+ *
+ * \param filters [in,out] if null, the test case will not be filtered
+ *
+ * \param d [out] the distance, if the test case was settled
+ *
+ * \return true if the test case was settled, false else
+ *
+ *
+ */
+
+template <typename StringView>
+bool
+prefiltered(StringView &A,
+            StringView &B,
+            std::size_t max_k,
+            dl::filter_stats *filters,
+            std::size_t &d)
+{
+  return filters && dl::prefilter(A, B, max_k, d, filters);
+}
+
+/**
+ * \brief Compute the distance between the two strings in a test case
+ *
+ *
+ * \param A [in] the first string in the test case
+ *
+ * \param B [in] the second string in the test case
+ *
+ * \param max_k [in] the threshold given to the algorithm
+ *
+ * \param filters [in,out] if non-null, try dl::prefilter first
+ *
+ * \param utf8 [in] if true, decode \a A & \a B from UTF-8 & compare them
+ * code point by code point, rather than byte by byte
+ *
+ * \param compare [in] a callable taking a pair of std::string_view or of
+ * std::u32string_view & returning the distance between them
+ *
+ * \return the distance between \a A & \a B
+ *
+ *
+ */
+
+template <typename F>
+std::size_t
+compare_pair(std::string_view A,
+             std::string_view B,
+             std::size_t max_k,
+             dl::filter_stats *filters,
+             bool utf8,
+             F compare)
+{
+  using namespace std;
+  size_t d;
+  if (utf8) {
+    // Each thread decodes into its own buffers, which are re-used from one
+    // test case to the next
+    thread_local u32string A32, B32;
+    dl::utf8_decode(A, A32);
+    dl::utf8_decode(B, B32);
+    u32string_view a = A32, b = B32;
+    if (!prefiltered(a, b, max_k, filters, d)) {
+      d = compare(a, b);
+    }
+  } else {
+    string_view a = A, b = B;
+    if (!prefiltered(a, b, max_k, filters, d)) {
+      d = compare(a, b);
+    }
+  }
+  return d;
+}
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
+ * using the algorithm of Lowrance & Wagner (1975)
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ * in this case, it is provided in case a given algorithm can optimize over all
+ * comparisons
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param filters [in,out] If non-null, each comparison is first handed to
+ * dl::prefilter, & the algorithm only run on those it can't settle; the
+ * stage that settled each is tallied here
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param tile_threads [in] If greater than one, spread each (unbounded)
+ * comparison over this many threads with dl::lowrance_wagner_parallel
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known D-L edit distance
+ * for each case in [p0, p1), false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_lowrance_wagner(FII p0,
+                     FII p1,
+                     size_t /*inf*/,
+                     size_t max_k,
+                     dl::filter_stats *filters,
+                     bool utf8,
+                     dl::workspace &ws,
+                     unsigned tile_threads,
+                     std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  size_t d = compare_pair(A, B, max_k, filters, utf8,
+                                          [&](auto a, auto b) {
+                    if (NO_MAX_K != max_k) {
+                      return dl::lowrance_wagner_within(a, b, max_k, ws);
+                    }
+                    return 1 < tile_threads ?
+                      dl::lowrance_wagner_parallel(a, b, tile_threads, ws) :
+                      dl::lowrance_wagner(a, b, ws);
+                  });
+                  return check_distance(A, B, get<2>(tc), max_k, d, verb);
+                });
+}
+
+/**
+ * \brief Check that an edit script turns one string into another
+ *
+ *
+ * \param A [in] the string to be edited
+ *
+ * \param B [in] the string into which \a A is to be edited
+ *
+ * \param S [in] the script, as returned by dl::edit_script
+ *
+ * \return true if applying \a S to \a A yields \a B, false else
+ *
+ *
+ */
+
+template <typename StringView>
+bool
+check_script(StringView A,
+             StringView B,
+             const std::vector<dl::edit> &S)
+{
+  using namespace std;
+  basic_string<typename StringView::value_type> out;
+  size_t a = 0;
+  for (size_t k = 0; k < S.size(); ++k) {
+    const dl::edit &e = S[k];
+    if (e.a < a || e.a > A.length() || e.b > B.length()) {
+      return false;
+    }
+    out.append(A.substr(a, e.a - a));
+    if (dl::edit_op::insert == e.op) {
+      out += B[e.b];
+      a = e.a;
+    } else if (dl::edit_op::erase == e.op) {
+      a = e.a + 1;
+    } else if (dl::edit_op::substitute == e.op) {
+      out += B[e.b];
+      a = e.a + 1;
+    } else {
+      // A transposition is followed by the erasures or insertions it entails
+      size_t y = e.a + 1;
+      while (k + 1 < S.size() && dl::edit_op::erase == S[k+1].op &&
+             y == S[k+1].a) {
+        ++y; ++k;
+      }
+      if (y >= A.length()) {
+        return false;
+      }
+      out += A[y];
+      while (k + 1 < S.size() && dl::edit_op::insert == S[k+1].op &&
+             y == S[k+1].a) {
+        out += B[S[++k].b];
+      }
+      out += A[e.a];
+      a = y + 1;
+    }
+  }
+  out.append(A.substr(a));
+  return out == B;
+}
+
+/**
+ * \brief Recover an edit script for each of a sequence of test cases with
+ * dl::edit_script
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * (including each script) shall be written
+ *
+ * \return true if, for each case in [p0, p1), the script recovered turns A
+ * into B in the known D-L edit distance, false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_edit_script(FII p0,
+                 FII p1,
+                 size_t /*inf*/,
+                 bool utf8,
+                 dl::workspace &ws,
+                 std::ostream *verb)
+{
+  using namespace std;
+  static const char OPS[] = { 'i', 'e', 's', 't' };
+  vector<dl::edit> S;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  bool ok = true;
+                  size_t d = compare_pair(A, B, NO_MAX_K, nullptr, utf8,
+                                          [&](auto a, auto b) {
+                    S = dl::edit_script(a, b, ws);
+                    ok = check_script(a, b, S);
+                    return S.size();
+                  });
+                  ok = check_distance(A, B, get<2>(tc), NO_MAX_K, d, verb) &&
+                    ok;
+                  if (verb) {
+                    *verb << "edit script:";
+                    for (const dl::edit &e: S) {
+                      *verb << ' ' << OPS[(int) e.op] << e.a << '/' << e.b;
+                    }
+                    *verb << (ok ? "" : " (wrong)") << endl;
+                  }
+                  return ok;
+                });
+}
+
+/**
+ * \brief Compute weighted Damerau-Levenshtein distance over a sequence of
+ * test cases using the algorithm of Lowrance & Wagner (1975)
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ *
+ * \param costs [in] The cost of each edit
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known weighted
+ * distance for each case in [p0, p1), false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_weighted(FII p0,
+              FII p1,
+              size_t /*inf*/,
+              const dl::cost_table &costs,
+              bool utf8,
+              dl::workspace &ws,
+              std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  double d;
+                  if (utf8) {
+                    thread_local u32string A32, B32;
+                    dl::utf8_decode(A, A32);
+                    dl::utf8_decode(B, B32);
+                    d = dl::lowrance_wagner(u32string_view(A32),
+                                            u32string_view(B32), costs, ws);
+                  } else {
+                    d = dl::lowrance_wagner(A, B, costs, ws);
+                  }
+                  if (verb) {
+                    *verb << "Comparing '" << A << "' (" << A.length() <<
+                      ") to '" << B << "' (" << B.length() <<
+                      "); computed cost: " << d << endl;
+                  }
+                  return d == (double) get<2>(tc);
+                });
+}
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
+ * using the algorithm of Ukkonen (1985)
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ * in this case, it is provided in case a given algorithm can optimize over all
+ * comparisons
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param filters [in,out] If non-null, each comparison is first handed to
+ * dl::prefilter, & the algorithm only run on those it can't settle; the
+ * stage that settled each is tallied here
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known D-L edit distance
+ * for each case in [p0, p1), false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_ukkonen(FII p0,
+             FII p1,
+             size_t /*inf*/,
+             size_t max_k,
+             dl::filter_stats *filters,
+             bool utf8,
+             dl::workspace &ws,
+             std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  size_t d = compare_pair(A, B, max_k, filters, utf8,
+                                          [&](auto a, auto b) {
+                    return NO_MAX_K == max_k ?
+                      dl::ukkonen(a, b, ws) :
+                      dl::ukkonen_within(a, b, max_k, ws);
+                  });
+                  return check_distance(A, B, get<2>(tc), max_k, d, verb);
+                });
+}
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
+ * using the algorithm of Berghel & Roach (1996)
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ * in this case, it is provided in case a given algorithm can optimize over all
+ * comparisons
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param filters [in,out] If non-null, each comparison is first handed to
+ * dl::prefilter, & the algorithm only run on those it can't settle; the
+ * stage that settled each is tallied here
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known D-L edit distance
+ * for each case in [p0, p1), false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_berghel_roach(FII p0,
+                   FII p1,
+                   size_t /*inf*/,
+                   size_t max_k,
+                   dl::filter_stats *filters,
+                   bool utf8,
+                   dl::workspace &ws,
+                   std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  size_t d = compare_pair(A, B, max_k, filters, utf8,
+                                          [&](auto a, auto b) {
+                    return NO_MAX_K == max_k ?
+                      dl::berghel_roach(a, b, ws) :
+                      dl::berghel_roach_within(a, b, max_k, ws);
+                  });
+                  return check_distance(A, B, get<2>(tc), max_k, d, verb);
+                });
+}
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
+ * using the algorithm of Hyyrö (2002)
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ * in this case, it is provided in case a given algorithm can optimize over all
+ * comparisons
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param filters [in,out] If non-null, each comparison is first handed to
+ * dl::prefilter, & the algorithm only run on those it can't settle; the
+ * stage that settled each is tallied here
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known D-L edit distance
+ * for each case in [p0, p1), false else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_hyyro(FII p0,
+           FII p1,
+           size_t /*inf*/,
+           size_t max_k,
+           dl::filter_stats *filters,
+           bool utf8,
+           dl::workspace &ws,
+           std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  size_t d = compare_pair(A, B, max_k, filters, utf8,
+                                          [&](auto a, auto b) {
+                    return NO_MAX_K == max_k ?
+                      dl::hyyro(a, b, ws) :
+                      dl::hyyro_within(a, b, max_k, ws);
+                  });
+                  return check_distance(A, B, get<2>(tc), max_k, d, verb);
+                });
+}
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
+ * using dl::query
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if this implementation calculated the known D-L edit distance
+ * for each case in [p0, p1), false else
+ *
+ *
+ * Each run of consecutive test cases sharing the same first string is treated
+ * as a single one-vs-many comparison: that string is pre-processed once into a
+ * dl::query, which then scores all the second strings in the run in one call.
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_query(FII p0,
+           FII p1,
+           size_t /*inf*/,
+           size_t max_k,
+           dl::workspace &ws,
+           std::ostream *verb)
+{
+  using namespace std;
+
+  vector<string_view> B;
+  vector<size_t> D;
+  while (p0 != p1) {
+    string_view A = get<0>(*p0);
+    FII pend = find_if(p0, p1, [&](const test_case &tc) {
+      return get<0>(tc) != A;
+    });
+
+    B.clear();
+    for (FII p = p0; p != pend; ++p) {
+      B.push_back(get<1>(*p));
+    }
+    D.resize(B.size());
+
+    dl::query q(A);
+    if (NO_MAX_K == max_k) {
+      q.distances(B.begin(), B.end(), D.begin(), ws);
+    } else {
+      q.distances_within(B.begin(), B.end(), max_k, D.begin(), ws);
+    }
+
+    for (size_t i = 0; p0 != pend; ++p0, ++i) {
+      if (!check_distance(A, B[i], get<2>(*p0), max_k, D[i], verb)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * \brief Compute both variants of the Damerau-Levenshtein distance over a
+ * sequence of test cases, & report the cases on which they disagree
+ *
+ *
+ * \param p0 [in] A forward input iterator referencing the beginning of a range
+ * of test cases
+ *
+ * \param p1 [in] A forward input iterator referencing the one-past-the-end
+ * position of a range of test cases
+ *
+ * \param inf [in] Maximum length across all strings in the test corpus; unused
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param var [in] The variant of the distance known for each test case
+ *
+ * \param utf8 [in] If true, the strings in each test case are decoded from
+ * UTF-8 & compared code point by code point
+ *
+ * \param ws [in,out] The workspace in which to carry-out each comparison
+ *
+ * \param out [in] The stream to which each test case on which the variants
+ * disagree shall be written, as "A<TAB>B<TAB>restricted<TAB>unrestricted"
+ *
+ * \param verb [in] If non-null, the stream to which verbose status messages
+ * shall be written
+ *
+ * \return true if dl::distance computed the known distance for each case in
+ * [p0, p1) & the unrestricted distance never exceeded the restricted, false
+ * else
+ *
+ *
+ */
+
+template <typename FII>
+bool
+test_variants(FII p0,
+              FII p1,
+              size_t /*inf*/,
+              size_t max_k,
+              dl::variant var,
+              bool utf8,
+              dl::workspace &ws,
+              std::ostream &out,
+              std::ostream *verb)
+{
+  using namespace std;
+  return all_of(p0,
+                p1,
+                [&](const test_case &tc) {
+                  string_view A = get<0>(tc), B = get<1>(tc);
+                  size_t d[2];
+                  for (dl::variant v: { dl::variant::osa,
+                                        dl::variant::unrestricted }) {
+                    d[(int)v] = compare_pair(A, B, max_k, nullptr, utf8,
+                                             [&](auto a, auto b) {
+                      return NO_MAX_K == max_k ?
+                        dl::distance(a, b, v, ws) :
+                        dl::distance_within(a, b, max_k, v, ws);
+                    });
+                  }
+                  size_t osa = d[(int)dl::variant::osa];
+                  size_t unr = d[(int)dl::variant::unrestricted];
+                  if (osa != unr) {
+                    out << A << '\t' << B << '\t' << osa << '\t' << unr <<
+                      '\n';
+                  }
+                  return unr <= osa &&
+                    check_distance(A, B, get<2>(tc), max_k, d[(int)var], verb);
+                });
+}
+
+#endif // HARNESS_HH_INCLUDED
@@ -0,0 +1,392 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "index_file.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+namespace {
+
+  const char MAGIC[8] = { 'D', 'L', 'I', 'N', 'D', 'E', 'X', '\0' };
+  const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+  const std::size_t ALIGNMENT = 64;
+
+  struct header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t kind;
+    std::uint32_t char_size;
+    std::uint32_t num_sections;
+    std::uint32_t num_params;
+    std::uint64_t params[dl::index_file::MAX_PARAMS];
+    /// The size of the entire file, in bytes
+    std::uint64_t file_size;
+    /// The checksum of [HEADER_SIZE, file_size)
+    std::uint64_t checksum;
+    struct {
+      std::uint64_t offset, size;
+    } sections[dl::index_file::MAX_SECTIONS];
+  };
+
+  /// The space given over to the header; the first section starts here
+  const std::size_t HEADER_SIZE =
+    (sizeof(header) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+  std::size_t
+  align(std::size_t n)
+  {
+    return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  }
+
+  /// A checksum computed incrementally: FNV-1a, taken eight bytes rather than
+  /// one at a time, so that it runs at something close to memory speed
+  class checksum
+  {
+  public:
+    /// Add \a n bytes at \a p
+    void update(const unsigned char *p, std::size_t n) {
+      while (n && nbuf_) {
+        buf_[nbuf_++] = *p++;
+        --n;
+        if (8 == nbuf_) {
+          mix(buf_);
+          nbuf_ = 0;
+        }
+      }
+      for ( ; n >= 8; p += 8, n -= 8) {
+        mix(p);
+      }
+      for ( ; n; --n) {
+        buf_[nbuf_++] = *p++;
+      }
+    }
+    /// Return the checksum of the bytes added so far (whose number must be a
+    /// multiple of eight)
+    std::uint64_t value() const {
+      return h_;
+    }
+
+  private:
+    void mix(const unsigned char *p) {
+      std::uint64_t w;
+      std::memcpy(&w, p, 8);
+      h_ ^= w;
+      h_ *= UINT64_C(0x100000001b3);
+    }
+
+  private:
+    std::uint64_t h_ = UINT64_C(0xcbf29ce484222325);
+    unsigned char buf_[8];
+    std::size_t nbuf_ = 0;
+  };
+
+  std::system_error
+  make_error(const char *what, const std::string &pth)
+  {
+    return std::system_error(errno, std::generic_category(),
+                             std::string(what) + " `" + pth + "'");
+  }
+
+  std::runtime_error
+  bad_file(const std::string &pth, const std::string &what)
+  {
+    return std::runtime_error("`" + pth + "' " + what);
+  }
+
+}
+
+dl::index_file::index_file(const std::string &pth, bool verify):
+  pth_(pth), p_(nullptr), n_(0), mapped_(false)
+{
+  int fd = open(pth.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    throw make_error("failed to open", pth);
+  }
+
+  struct stat st;
+  if (0 != fstat(fd, &st)) {
+    std::system_error err = make_error("failed to stat", pth);
+    close(fd);
+    throw err;
+  }
+
+# if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  // Regular files are mapped (shared, so that every process mapping the
+  // same index shares its pages)...
+  if (S_ISREG(st.st_mode) && 0 < st.st_size) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED != p) {
+      p_ = (const unsigned char*)p;
+      n_ = st.st_size;
+      mapped_ = true;
+    }
+  }
+# endif
+
+  // while anything else is read into a buffer.
+  if (!mapped_) {
+    const std::size_t CHUNK = 1 << 16;
+    std::size_t n = 0;
+    for ( ; ; ) {
+      buf_.resize((n + CHUNK + 7) / 8);
+      ssize_t nread = read(fd, (char*)buf_.data() + n, CHUNK);
+      if (-1 == nread) {
+        if (EINTR == errno) continue;
+        std::system_error err = make_error("failed to read", pth);
+        close(fd);
+        throw err;
+      }
+      n += nread;
+      if (0 == nread) break;
+    }
+    buf_.resize((n + 7) / 8);
+    p_ = (const unsigned char*)buf_.data();
+    n_ = n;
+  }
+  close(fd);
+
+  // Check everything that can be checked without reading the sections.
+  try {
+    if (n_ < HEADER_SIZE) {
+      throw bad_file(pth_, "is too small to be an index file");
+    }
+    const header &h = *(const header*)p_;
+    if (0 != std::memcmp(h.magic, MAGIC, sizeof(MAGIC))) {
+      throw bad_file(pth_, "is not an index file");
+    }
+    if (BYTE_ORDER_MARK != h.byte_order) {
+      throw bad_file(pth_, "was written on a machine of different byte order");
+    }
+    if (FORMAT_VERSION != h.version) {
+      throw bad_file(pth_, "is version " + std::to_string(h.version) +
+                           " of the index format (this is version " +
+                           std::to_string(FORMAT_VERSION) + ")");
+    }
+    if (h.file_size != n_) {
+      throw bad_file(pth_, "is truncated");
+    }
+    if (h.num_sections > MAX_SECTIONS || h.num_params > MAX_PARAMS) {
+      throw bad_file(pth_, "has a malformed header");
+    }
+    for (std::uint32_t i = 0; i < h.num_sections; ++i) {
+      std::uint64_t off = h.sections[i].offset, sz = h.sections[i].size;
+      if (off % ALIGNMENT || off < HEADER_SIZE || off > n_ || sz > n_ - off) {
+        throw bad_file(pth_, "has a malformed header");
+      }
+    }
+    if (verify) {
+      this->verify();
+    }
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+dl::index_file::index_file(index_file &&that) noexcept:
+  pth_(std::move(that.pth_)),
+  p_(that.p_),
+  n_(that.n_),
+  mapped_(that.mapped_),
+  buf_(std::move(that.buf_))
+{
+  that.p_ = nullptr;
+  that.n_ = 0;
+  that.mapped_ = false;
+}
+
+dl::index_file::~index_file()
+{
+  release();
+}
+
+dl::index_file&
+dl::index_file::operator=(index_file &&that) noexcept
+{
+  if (this != &that) {
+    release();
+    pth_ = std::move(that.pth_);
+    p_ = that.p_;
+    n_ = that.n_;
+    mapped_ = that.mapped_;
+    buf_ = std::move(that.buf_);
+    that.p_ = nullptr;
+    that.n_ = 0;
+    that.mapped_ = false;
+  }
+  return *this;
+}
+
+dl::index_kind
+dl::index_file::kind() const
+{
+  return (index_kind)((const header*)p_)->kind;
+}
+
+std::size_t
+dl::index_file::char_size() const
+{
+  return ((const header*)p_)->char_size;
+}
+
+std::uint64_t
+dl::index_file::param(std::size_t i) const
+{
+  const header &h = *(const header*)p_;
+  if (i >= h.num_params) {
+    throw bad_file(pth_, "has no parameter " + std::to_string(i));
+  }
+  return h.params[i];
+}
+
+void
+dl::index_file::expect(index_kind k, std::size_t char_size) const
+{
+  if (k != kind()) {
+    throw bad_file(pth_, "holds a different kind of index");
+  }
+  if (char_size != this->char_size()) {
+    throw bad_file(pth_, "holds an index over " +
+                         std::to_string(this->char_size()) +
+                         "-byte characters");
+  }
+}
+
+void
+dl::index_file::verify() const
+{
+  const header &h = *(const header*)p_;
+  checksum ck;
+  ck.update(p_ + HEADER_SIZE, n_ - HEADER_SIZE);
+  if ((n_ - HEADER_SIZE) % 8 || ck.value() != h.checksum) {
+    throw bad_file(pth_, "is corrupt (its checksum is wrong)");
+  }
+}
+
+std::pair<const void*, std::size_t>
+dl::index_file::section_bytes(std::size_t i) const
+{
+  const header &h = *(const header*)p_;
+  if (i >= h.num_sections) {
+    throw bad_file(pth_, "has no section " + std::to_string(i));
+  }
+  return std::make_pair(p_ + h.sections[i].offset, h.sections[i].size);
+}
+
+void
+dl::index_file::release()
+{
+# if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  if (mapped_) {
+    munmap((void*)p_, n_);
+  }
+# endif
+  p_ = nullptr;
+  n_ = 0;
+  mapped_ = false;
+  std::vector<std::uint64_t>().swap(buf_);
+}
+
+void
+dl::write_index_file(const std::string &pth,
+                     index_kind kind,
+                     std::size_t char_size,
+                     const std::vector<std::uint64_t> &params,
+                     const std::vector<index_section> &sections)
+{
+  using namespace std;
+
+  if (params.size() > index_file::MAX_PARAMS ||
+      sections.size() > index_file::MAX_SECTIONS) {
+    throw invalid_argument("too many parameters or sections for an index file");
+  }
+
+  // Lay the sections out, each on a fresh boundary...
+  header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = index_file::FORMAT_VERSION;
+  h.byte_order = BYTE_ORDER_MARK;
+  h.kind = (uint32_t)kind;
+  h.char_size = (uint32_t)char_size;
+  h.num_sections = (uint32_t)sections.size();
+  h.num_params = (uint32_t)params.size();
+  copy(params.begin(), params.end(), h.params);
+  size_t off = HEADER_SIZE;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    h.sections[i].offset = off;
+    h.sections[i].size = sections[i].size;
+    off = align(off + sections[i].size);
+  }
+  h.file_size = off;
+
+  // compute the checksum (over the padding, too)...
+  static const unsigned char ZEROS[ALIGNMENT] = { 0 };
+  auto padding = [](size_t n) { return align(n) - n; };
+  checksum ck;
+  for (const index_section &s: sections) {
+    ck.update((const unsigned char*)s.data, s.size);
+    ck.update(ZEROS, padding(s.size));
+  }
+  h.checksum = ck.value();
+
+  // & write the lot to a temporary file, which is then renamed into place.
+  string tmp = pth + ".tmp";
+  FILE *fp = fopen(tmp.c_str(), "wb");
+  if (!fp) {
+    throw make_error("failed to open", tmp);
+  }
+  bool ok = 1 == fwrite(&h, sizeof(h), 1, fp) &&
+    HEADER_SIZE - sizeof(h) == fwrite(ZEROS, 1, HEADER_SIZE - sizeof(h), fp);
+  for (size_t i = 0; ok && i < sections.size(); ++i) {
+    const index_section &s = sections[i];
+    ok = s.size == fwrite(s.data, 1, s.size, fp) &&
+      padding(s.size) == fwrite(ZEROS, 1, padding(s.size), fp);
+  }
+  if (!ok) {
+    system_error err = make_error("failed to write", tmp);
+    fclose(fp);
+    remove(tmp.c_str());
+    throw err;
+  }
+  if (0 != fclose(fp)) {
+    system_error err = make_error("failed to write", tmp);
+    remove(tmp.c_str());
+    throw err;
+  }
+  if (0 != rename(tmp.c_str(), pth.c_str())) {
+    system_error err = make_error("failed to rename", tmp);
+    remove(tmp.c_str());
+    throw err;
+  }
+}
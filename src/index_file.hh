@@ -0,0 +1,283 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef INDEX_FILE_HH_INCLUDED
+#define INDEX_FILE_HH_INCLUDED 1
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dl {
+
+  /// The sorts of dictionary index that may be saved to an index file
+  enum class index_kind : std::uint32_t {
+    /// dl::basic_bk_tree
+    bk_tree = 1,
+    /// dl::basic_trie
+    trie = 2,
+    /// dl::basic_deletion_index
+    deletion = 3,
+  };
+
+  /**
+   * \brief An array making up part of a dictionary index
+   *
+   *
+   * An index built in memory owns its arrays, but one loaded from a
+   * dl::index_file merely refers to the file's contents, so that loading it
+   * costs nothing beyond mapping the file. This is the type of each such
+   * array: a read-only view of either a std::vector it owns or memory it
+   * borrows.
+   *
+   *
+   */
+
+  template <typename T>
+  class index_array
+  {
+  public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "index arrays are written to disk as they lie in memory");
+    typedef const T* const_iterator;
+
+  public:
+    index_array() = default;
+    index_array(const index_array &that):
+      own_(that.own_),
+      p_(that.owned() ? own_.data() : that.p_),
+      n_(that.n_)
+    { }
+    // Moving a vector doesn't move its elements, so p_ remains valid either
+    // way
+    index_array(index_array &&that) noexcept:
+      own_(std::move(that.own_)),
+      p_(that.p_),
+      n_(that.n_)
+    { }
+    index_array& operator=(index_array that) noexcept {
+      own_.swap(that.own_);
+      p_ = that.p_;
+      n_ = that.n_;
+      return *this;
+    }
+
+  public:
+    /// Take ownership of \a v
+    void assign(std::vector<T> &&v) {
+      own_ = std::move(v);
+      p_ = own_.data();
+      n_ = own_.size();
+    }
+    /// Refer to the \a n objects at \a p, which must outlive this array
+    void borrow(const T *p, std::size_t n) {
+      std::vector<T>().swap(own_);
+      p_ = p;
+      n_ = n;
+    }
+
+  public:
+    const T* data() const {
+      return p_;
+    }
+    std::size_t size() const {
+      return n_;
+    }
+    bool empty() const {
+      return 0 == n_;
+    }
+    const T& operator[](std::size_t i) const {
+      return p_[i];
+    }
+    const T& back() const {
+      return p_[n_ - 1];
+    }
+    const_iterator begin() const {
+      return p_;
+    }
+    const_iterator end() const {
+      return p_ + n_;
+    }
+
+  private:
+    bool owned() const {
+      return p_ == own_.data() && !own_.empty();
+    }
+
+  private:
+    std::vector<T> own_;
+    const T *p_ = nullptr;
+    std::size_t n_ = 0;
+  };
+
+  /**
+   * \brief A dictionary index saved to disk, mapped into memory
+   *
+   *
+   * Building an index over a large dictionary takes a while; a service that
+   * must start quickly should build it once, save it (each index has a save
+   * method) & load it from the resulting file on start-up. Loading is
+   * constant-time: the file is mapped read-only & shared (so that processes
+   * serving the same index share its pages), & the index's arrays refer to
+   * the mapping directly, with no deserialization pass. Each index type has
+   * a constructor taking an index_file; the file must outlive the index.
+   *
+   * An index file is a fixed-size header followed by the index's arrays (its
+   * "sections"), each beginning on a 64-byte boundary. The header records:
+   *
+   * - a magic number & a format version
+   * - the byte order in which the file was written (files are only readable
+   *   on machines of the same byte order)
+   * - the kind of index & the size of its characters
+   * - up to four integer parameters particular to that kind of index
+   * - the size of the file & a 64-bit checksum of everything after the header
+   * - the offset (from the start of the file) & size of each section
+   *
+   * Nothing in any section is a pointer; the nodes of each index refer to
+   * one another by position.
+   *
+   * Opening a file checks everything in the header that can be checked in
+   * constant time: the magic number, version, byte order & file size, & that
+   * every section is aligned & lies within the file. Checking the checksum
+   * means reading the entire file, so it's only done on request.
+   *
+   * If mmap isn't available, the file is read into memory instead.
+   *
+   *
+   */
+
+  class index_file
+  {
+  public:
+    /// The version of the format written by this library
+    static const std::uint32_t FORMAT_VERSION = 1;
+    /// The largest number of sections in a file
+    static const std::size_t MAX_SECTIONS = 8;
+    /// The largest number of parameters in a file
+    static const std::size_t MAX_PARAMS = 4;
+
+  public:
+    /**
+     * \brief Open an index file
+     *
+     *
+     * \param pth [in] the path of the file
+     *
+     * \param verify [in] if true, check the file's checksum, too
+     *
+     *
+     * Throws std::system_error if the file can't be read, &
+     * std::runtime_error if it isn't an index file (of a version & byte-order
+     * this library can read) or is found to be corrupt.
+     *
+     *
+     */
+    explicit index_file(const std::string &pth, bool verify = false);
+    index_file(const index_file &) = delete;
+    index_file(index_file &&that) noexcept;
+    ~index_file();
+    index_file& operator=(const index_file &) = delete;
+    index_file& operator=(index_file &&that) noexcept;
+
+  public:
+    /// Return the kind of index in this file
+    index_kind kind() const;
+    /// Return the size, in bytes, of the index's characters
+    std::size_t char_size() const;
+    /// Return the \a i-th parameter of the index
+    std::uint64_t param(std::size_t i) const;
+    /// Throw std::runtime_error unless this file holds an index of kind \a k
+    /// over characters of \a char_size bytes
+    void expect(index_kind k, std::size_t char_size) const;
+    /// Check the checksum, throwing std::runtime_error if it's wrong
+    void verify() const;
+
+    /// Point \a out at the \a i-th section; throws std::runtime_error if its
+    /// size isn't a multiple of sizeof(T)
+    template <typename T>
+    void section(std::size_t i, index_array<T> &out) const {
+      std::pair<const void*, std::size_t> s = section_bytes(i);
+      if (s.second % sizeof(T)) {
+        throw std::runtime_error("`" + pth_ + "': section " +
+                                 std::to_string(i) + " is malformed");
+      }
+      out.borrow(static_cast<const T*>(s.first), s.second / sizeof(T));
+    }
+
+  private:
+    std::pair<const void*, std::size_t> section_bytes(std::size_t i) const;
+    void release();
+
+  private:
+    std::string pth_;
+    const unsigned char *p_;
+    std::size_t n_;
+    /// True if p_ was obtained from mmap, false if it points into buf_
+    bool mapped_;
+    /// Eight-byte elements, so that the sections are suitably aligned
+    std::vector<std::uint64_t> buf_;
+  };
+
+  /// One section of an index to be written by write_index_file
+  struct index_section {
+    const void *data;
+    std::size_t size;
+
+    template <typename T>
+    index_section(const index_array<T> &a):
+      data(a.data()), size(a.size() * sizeof(T))
+    { }
+  };
+
+  /**
+   * \brief Write an index file
+   *
+   *
+   * \param pth [in] the path to which the file shall be written; any
+   * existing file there is replaced
+   *
+   * \param kind [in] the kind of index being written
+   *
+   * \param char_size [in] the size, in bytes, of its characters
+   *
+   * \param params [in] the parameters of the index (no more than
+   * index_file::MAX_PARAMS)
+   *
+   * \param sections [in] its arrays (no more than index_file::MAX_SECTIONS),
+   * in the order in which index_file::section will be asked for them
+   *
+   *
+   * This is the implementation of each index's save method. The file is
+   * written alongside \a pth & renamed into place once complete, so that a
+   * process loading the index never sees a partial file. Throws
+   * std::system_error on failure.
+   *
+   *
+   */
+
+  void
+  write_index_file(const std::string &pth,
+                   index_kind kind,
+                   std::size_t char_size,
+                   const std::vector<std::uint64_t> &params,
+                   const std::vector<index_section> &sections);
+
+} // namespace dl
+
+#endif // INDEX_FILE_HH_INCLUDED
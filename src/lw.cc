@@ -15,75 +15,246 @@
 
 #include "config.h"
 #include "lw.hh"
+#include "lw_simd.hh"
+#include "lw_tiles.hh"
+#include "parallel.hh"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
-bool
-lowrance_wagner(const std::string &A,
-                const std::string &B,
-                std::size_t known_dist,
-                bool verb)
-{
-  using namespace std;
+namespace {
 
-  // For all `i', for any character `c', DA[`c'] is the largest x <= i - 1 such
-  // that A[x] = c for all `c' in A & B. Since I'm restricting strings to ASCII,
-  // I'm just using a 128-element array to store the lookup table.
-  size_t DA[128] = { 0 };
+  using dl::detail::TILE_COLS;
+  using dl::detail::TILE_ROWS;
+  using dl::detail::tiling;
 
-  size_t nA = A.length(), nB = B.length();
-  // Lowrance & Wagner add an additional index -1 to both dimensions and set the
-  // -1 row & -1 column to INF.
-  size_t INF = nA + nB + 1;
+  template <typename CharT>
+  std::size_t
+  lw(std::basic_string_view<CharT> A,
+     std::basic_string_view<CharT> B,
+     std::size_t max_k,
+     unsigned num_threads,
+     dl::workspace &ws)
+  {
+    using namespace std;
 
-  // This is the (in)famous matrix
-  size_t H[(nA + 1)*(nB + 1)];
+    size_t nA = A.length(), nB = B.length();
 
-  for (size_t i = 0; i <= nA; ++i) {
-    H[i*nB] = i;
-  }
-  for (size_t j = 0; j <= nB; ++j) {
-    H[j] = j;
-  }
+    dl::work_stats work;
+    work.comparisons = 1;
+    auto done = [&ws, &work](size_t d) {
+      ws.add_work(work);
+      return d;
+    };
 
-  for (size_t i = 1, im1 = 0; i <= nA; ++i, ++im1) {
-    size_t DB = 0;
-    for (size_t j = 1; j <= nB; ++j) {
-      size_t i1 = DA[B[j-1]];
-      size_t j1 = DB;
-      size_t d = 0;
-      if (A[im1] != B[j-1]) {
-        d = 1;
-      } else {
-        DB = j;
-      }
-      size_t h1 = H[im1*nB + j - 1] + d;
-      size_t h2 = H[i*nB + j - 1] + 1;
-      size_t h3 = H[im1*nB + j] + 1;
-      size_t h4 = INF;
-      if (i1 > 0 && j1 > 0) {
-        h4 = H[(i1-1)*nB + j1-1] + (im1-i1) + 1 + (j-j1-1);
+    // The distance is at least the difference in lengths...
+    if ((nA > nB ? nA - nB : nB - nA) > max_k) {
+      return done(max_k + 1);
+    }
+    if (0 == nA || 0 == nB) {
+      return done(nA + nB);
+    }
+
+    // Lowrance & Wagner add an additional index -1 to both dimensions and set
+    // the -1 row & -1 column to INF. Rather than keep the (in)famous
+    // (nA + 1) x (nB + 1) matrix, we compute it a tile at a time, keeping
+    // only what's needed by the tiles yet to be computed (see `tiling').
+    // Each worker needs a buffer of its own, on its own cache lines.
+    if (0 == num_threads) num_threads = 1;
+    size_t nbuf = (3*(TILE_COLS + 2) + 7) / 8 * 8;
+    size_t *p = ws.reserve<size_t>(num_threads*nbuf + tiling::words(nA, nB));
+    tiling t(nA, nB, p + num_threads*nbuf);
+
+    // The minimum over each row never decreases from one row to the next:
+    // every term in the recurrence is at least the minimum of the preceding
+    // row (h4 reaches back to row i1 - 1, but pays at least one for each row
+    // skipped). So if every entry in a row exceeds `max_k', so will the
+    // distance.
+    //
+    // The tiles computed are only counted if someone's asking; they may be
+    // computed on several threads at once.
+    bool counting = nullptr != ws.work();
+    atomic<size_t> cells(0);
+    auto f = [&](unsigned w, size_t I, size_t J) {
+      if (counting) {
+        cells.fetch_add(min(TILE_ROWS, nA - I*TILE_ROWS) *
+                        min(TILE_COLS, nB - J*TILE_COLS),
+                        memory_order_relaxed);
       }
-      if (h2 < h1) h1 = h2;
-      if (h3 < h1) h1 = h3;
-      if (h4 < h1) h1 = h4;
-      H[i*nB + j] = h1;
+      return dl::detail::tile(t, A, B, I, J, p + w*nbuf, max_k);
+    };
+    bool finished = dl::parallel_wavefront(t.num_rows, t.num_cols,
+                                           num_threads, f);
+    work.cells = cells.load();
+    if (!finished) {
+      return done(max_k + 1);
     }
-    DA[A[im1]] = i;
+
+    size_t d = t.top1[nB];
+    return done(d > max_k ? max_k + 1 : d);
   }
+}
 
-  if (verb) {
-    cout << "computed distance is " << H[nA*nB + nB] << endl;
-    for (size_t i = 0; i <= nA; ++i) {
-      for (size_t j = 0; j <= nB; ++j) {
-        if (j == 0) {
-          cout << "|";
-        }
-        cout << " " << H[i*nB + j] << " |";
-      }
-      cout << endl;
+std::size_t
+dl::lowrance_wagner(std::string_view A,
+                    std::string_view B)
+{
+  return lowrance_wagner(A, B, this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner(std::string_view A,
+                    std::string_view B,
+                    workspace &ws)
+{
+  // The vectorized kernel has no early exit, so it's only used when we're
+  // asked for the distance outright
+  if (detail::lowrance_wagner_simd_ok(A.length(), B.length())) {
+    if (ws.work()) {
+      work_stats work;
+      work.comparisons = 1;
+      work.cells = A.length()*B.length();
+      ws.add_work(work);
     }
+    return detail::lowrance_wagner_simd(A, B, ws);
   }
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_within(std::string_view A,
+                           std::string_view B,
+                           std::size_t max_k)
+{
+  return lw(A, B, max_k, 1, this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner_within(std::string_view A,
+                           std::string_view B,
+                           std::size_t max_k,
+                           workspace &ws)
+{
+  return lw(A, B, max_k, 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner(std::u16string_view A,
+                    std::u16string_view B)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), 1,
+            this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner(std::u16string_view A,
+                    std::u16string_view B,
+                    workspace &ws)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_within(std::u16string_view A,
+                           std::u16string_view B,
+                           std::size_t max_k)
+{
+  return lw(A, B, max_k, 1, this_thread_workspace());
+}
 
-  return H[nA*nB + nB] == known_dist;
+std::size_t
+dl::lowrance_wagner_within(std::u16string_view A,
+                           std::u16string_view B,
+                           std::size_t max_k,
+                           workspace &ws)
+{
+  return lw(A, B, max_k, 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner(std::u32string_view A,
+                    std::u32string_view B)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), 1,
+            this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner(std::u32string_view A,
+                    std::u32string_view B,
+                    workspace &ws)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_within(std::u32string_view A,
+                           std::u32string_view B,
+                           std::size_t max_k)
+{
+  return lw(A, B, max_k, 1, this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner_within(std::u32string_view A,
+                           std::u32string_view B,
+                           std::size_t max_k,
+                           workspace &ws)
+{
+  return lw(A, B, max_k, 1, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::string_view A,
+                             std::string_view B,
+                             unsigned num_threads)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads,
+            this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::string_view A,
+                             std::string_view B,
+                             unsigned num_threads,
+                             workspace &ws)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::u16string_view A,
+                             std::u16string_view B,
+                             unsigned num_threads)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads,
+            this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::u16string_view A,
+                             std::u16string_view B,
+                             unsigned num_threads,
+                             workspace &ws)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads, ws);
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::u32string_view A,
+                             std::u32string_view B,
+                             unsigned num_threads)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads,
+            this_thread_workspace());
+}
+
+std::size_t
+dl::lowrance_wagner_parallel(std::u32string_view A,
+                             std::u32string_view B,
+                             unsigned num_threads,
+                             workspace &ws)
+{
+  return lw(A, B, std::numeric_limits<std::size_t>::max(), num_threads, ws);
 }
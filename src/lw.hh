@@ -16,98 +16,401 @@
 #ifndef LW_H_INCLUDED
 #define LW_H_INCLUDED 1
 
+#include "costs.hh"
+#include "workspace.hh"
+
 #include <algorithm>
-#include <string>
-#include <tuple>
-
-/**
- * \brief Compute the Damerau-Levenshtein distance between two strings using the
- * algorithm of Lowrance & Wagner (1975)
- *
- *
- * \param A [in] the first of the two strings whose Damerau-Levenshtein distance
- * is to be computed
- *
- * \param B [in] the second of the two strings whose Damerau-Levenshtein
- * distance is to be computed
- *
- * \param D [in] the known Damerau-Levenshtein distance between \a A & \a B
- *
- * \param verb [in] if true, produce verbose progress messages on \c stdout
- *
- * \return true if the edit distance is computed to be D, false else
- *
- *
- * This function will employ "Algorithm S" in the paper "An Extension of the
- * String-to-String Correction Problem" in the Journal of the ACM, Vol. 22,
- * No. 2., April 1975 by Roy Lowrance & Robert A. Wagner to compute the
- * Damerau-Levenshtein distance between \a A & \a B. If it is equal to \a D, it
- * will return true (or false, else).
- *
- * The algorithm runs in both time & space O(m*n) where m & n are the lengths
- * of \a A & \a B, respectively.
- *
- * This was, AFAICT, the seminal paper on this problem. In fact, it's list of
- * references contains only one entry. The bulk of the paper is concerned with
- * proving that the minimal D-L edit distance can be computed using only
- * adjacent transpositions-- the computation of the (today, well-known)
- * recurrence relation is almost an afterthought.
- *
- *
- */
-
-bool
-lowrance_wagner(const std::string &A,
-                const std::string &B,
-                std::size_t D,
-                bool verb);
-
-/**
- * \brief Compute Damerau-Levenshtein distance over a sequence of test cases
- * using the algorithm of Lowrance & Wagner (1975)
- *
- *
- * \param p0 [in] A forward input iterator referencing the beginning of a range
- * of test cases (on which more below)
- *
- * \param p1 [in] A forward input iterator referencing the one-past-the-end
- * position of a range of test cases
- *
- * \param inf [in] Maximum length across all strings in the test corpus; unused
- * in this case, it is provided in case a given algorithm can optimize over all
- * comparisons
- *
- * \param verb [in] If true, produce verbose status messages on \c stdout
- *
- * \return true if this implementation calculated the known D-L edit distance
- * for each case in [p0, p1), false else
- *
- *
- * A "test case" is simply a three-tuple: string "A", string "B", and the known
- * distance between them. IOW, type \a FII shall dereference to
- * std::tuple(std::string, std::string, std::size_t). I arrange for all D-L
- * algorithms in this program to take a range of test cases (instead of a single
- * test case) to enable them to take advantage any one-time initialization logic
- * or other global optimizations which they may provide.
- *
- *
- */
-
-template <typename FII>
-bool
-test_lowrance_wagner(FII p0,
-                     FII p1,
-                     size_t /*inf*/,
-                     bool verb)
-{
-  using namespace std;
-  return all_of(p0,
-                p1,
-                [&](const tuple<string, string, size_t> &tc) {
-                  string A, B;
-                  size_t d;
-                  tie(A, B, d) = tc;
-                  return lowrance_wagner(A, B, d, verb);
-                });
-}
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+namespace dl {
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the algorithm of Lowrance & Wagner (1975)
+   *
+   *
+   * \param A [in] the first of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \param B [in] the second of the two strings whose Damerau-Levenshtein
+   * distance is to be computed
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B
+   *
+   *
+   * This function will employ "Algorithm S" in the paper "An Extension of the
+   * String-to-String Correction Problem" in the Journal of the ACM, Vol. 22,
+   * No. 2., April 1975 by Roy Lowrance & Robert A. Wagner to compute the
+   * Damerau-Levenshtein distance between \a A & \a B.
+   *
+   * The algorithm runs in time O(m*n) where m & n are the lengths of \a A &
+   * \a B, respectively. Rather than keep the entire m x n matrix, the
+   * recurrence is evaluated in tiles of 64 rows by 256 columns, keeping only
+   * the last two rows & columns of each tile (plus a little state for the
+   * transposition term; see lw.cc), so that the space required is O(m+n) &
+   * each tile's working set stays in L1. The space is taken from the calling
+   * thread's workspace (see this_thread_workspace).
+   *
+   * Moderately long strings of 8-bit characters are instead handled by a
+   * vectorized kernel, when the CPU supports it (see lw_simd.hh); that keeps
+   * the full matrix, & so is only used while it occupies no more than 64MB.
+   *
+   * This was, AFAICT, the seminal paper on this problem. In fact, it's list of
+   * references contains only one entry. The bulk of the paper is concerned with
+   * proving that the minimal D-L edit distance can be computed using only
+   * adjacent transpositions-- the computation of the (today, well-known)
+   * recurrence relation is almost an afterthought.
+   *
+   *
+   */
+
+  std::size_t
+  lowrance_wagner(std::string_view A,
+                  std::string_view B);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B using the
+  /// algorithm of Lowrance & Wagner (1975) in the workspace \a ws
+  std::size_t
+  lowrance_wagner(std::string_view A,
+                  std::string_view B,
+                  workspace &ws);
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two strings using
+   * the algorithm of Lowrance & Wagner (1975), giving up once it is known to
+   * exceed a given threshold
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param max_k [in] the largest distance of interest to the caller
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B if that is
+   * less than or equal to \a max_k, or \a max_k + 1 otherwise
+   *
+   *
+   * The minimum over each row of the recurrence relation never decreases from
+   * one row to the next, so once an entire row exceeds \a max_k, so must the
+   * final distance & we can stop there. That doesn't change the worst-case
+   * running time, but it can sharply curtail the work done on dissimilar
+   * strings.
+   *
+   *
+   */
+
+  std::size_t
+  lowrance_wagner_within(std::string_view A,
+                         std::string_view B,
+                         std::size_t max_k);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B, up to
+  /// \a max_k, using the algorithm of Lowrance & Wagner (1975) in the
+  /// workspace \a ws
+  std::size_t
+  lowrance_wagner_within(std::string_view A,
+                         std::string_view B,
+                         std::size_t max_k,
+                         workspace &ws);
+
+  /**
+   * \brief Compute the Damerau-Levenshtein distance between two (very long)
+   * strings using the algorithm of Lowrance & Wagner (1975), on several
+   * threads
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param num_threads [in] the number of threads to use (including the
+   * calling thread)
+   *
+   * \return the Damerau-Levenshtein distance between \a A & \a B
+   *
+   *
+   * This is for the occasional comparison of two strings of tens of
+   * thousands of characters or more (log lines, serialized records), which
+   * would take seconds on a single core. The tiles of the recurrence (see
+   * above) are handed out to \a num_threads threads, each tile as soon as
+   * the tiles above & to the left of it are done (see
+   * dl::parallel_wavefront), so that the tiles along each anti-diagonal are
+   * computed concurrently. Aside from the ramp up & down at the corners of
+   * the matrix, the threads are kept busy; the speed-up approaches \a
+   * num_threads once each string spans many times \a num_threads tiles.
+   *
+   * The result is exactly that of lowrance_wagner, however many threads are
+   * used. The threads are started (& joined) on each call, so this is no
+   * help for short strings. The state shared between the tiles is taken from
+   * the calling thread's workspace.
+   *
+   *
+   */
+
+  std::size_t
+  lowrance_wagner_parallel(std::string_view A,
+                           std::string_view B,
+                           unsigned num_threads);
+
+  /// Compute the Damerau-Levenshtein distance between \a A & \a B using the
+  /// algorithm of Lowrance & Wagner (1975) on \a num_threads threads, in the
+  /// workspace \a ws
+  std::size_t
+  lowrance_wagner_parallel(std::string_view A,
+                           std::string_view B,
+                           unsigned num_threads,
+                           workspace &ws);
+
+  /// As above, for strings of 16-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  lowrance_wagner(std::u16string_view A,
+                  std::u16string_view B);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::size_t
+  lowrance_wagner(std::u16string_view A,
+                  std::u16string_view B,
+                  workspace &ws);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k
+  std::size_t
+  lowrance_wagner_within(std::u16string_view A,
+                         std::u16string_view B,
+                         std::size_t max_k);
+
+  /// As above, for strings of 16-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  lowrance_wagner_within(std::u16string_view A,
+                         std::u16string_view B,
+                         std::size_t max_k,
+                         workspace &ws);
+
+  /// As above, for strings of 16-bit characters, on \a num_threads threads
+  std::size_t
+  lowrance_wagner_parallel(std::u16string_view A,
+                           std::u16string_view B,
+                           unsigned num_threads);
+
+  /// As above, for strings of 16-bit characters, on \a num_threads threads,
+  /// in the workspace \a ws
+  std::size_t
+  lowrance_wagner_parallel(std::u16string_view A,
+                           std::u16string_view B,
+                           unsigned num_threads,
+                           workspace &ws);
+
+  /// As above, for strings of 32-bit characters (see the discussion of
+  /// character types in damlev.hh)
+  std::size_t
+  lowrance_wagner(std::u32string_view A,
+                  std::u32string_view B);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::size_t
+  lowrance_wagner(std::u32string_view A,
+                  std::u32string_view B,
+                  workspace &ws);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k
+  std::size_t
+  lowrance_wagner_within(std::u32string_view A,
+                         std::u32string_view B,
+                         std::size_t max_k);
+
+  /// As above, for strings of 32-bit characters, up to \a max_k, in the
+  /// workspace \a ws
+  std::size_t
+  lowrance_wagner_within(std::u32string_view A,
+                         std::u32string_view B,
+                         std::size_t max_k,
+                         workspace &ws);
+
+  /// As above, for strings of 32-bit characters, on \a num_threads threads
+  std::size_t
+  lowrance_wagner_parallel(std::u32string_view A,
+                           std::u32string_view B,
+                           unsigned num_threads);
+
+  /// As above, for strings of 32-bit characters, on \a num_threads threads,
+  /// in the workspace \a ws
+  std::size_t
+  lowrance_wagner_parallel(std::u32string_view A,
+                           std::u32string_view B,
+                           unsigned num_threads,
+                           workspace &ws);
+
+  namespace detail {
+
+    /// Compute the cost of the cheapest edits turning \a A into \a B under
+    /// \a costs, with Lowrance & Wagner's recurrence over the full matrix
+    template <typename Costs, typename CharT>
+    typename Costs::cost_type
+    weighted_lowrance_wagner(std::basic_string_view<CharT> A,
+                             std::basic_string_view<CharT> B,
+                             const Costs &costs,
+                             workspace &ws)
+    {
+      using namespace std;
+
+      typedef typename Costs::cost_type cost_type;
+      if constexpr (is_same_v<Costs, unit_costs>) {
+        return dl::lowrance_wagner(A, B, ws);
+      } else {
+        size_t nA = A.length(), nB = B.length(), W = nB + 1;
+        const cost_type I = costs.insertion(), D = costs.deletion();
+
+        if (ws.work()) {
+          work_stats work;
+          work.comparisons = 1;
+          work.cells = nA*nB;
+          ws.add_work(work);
+        }
+
+        // For each column j, the last row i1 before this one at which
+        // A[i1-1] = B[j-1] (which does the job of the table DA), followed
+        // by the matrix, at H(i,j) = H[i*W + j]
+        size_t off = (W*sizeof(size_t) + alignof(cost_type) - 1) /
+          alignof(cost_type) * alignof(cost_type);
+        unsigned char *p =
+          ws.reserve<unsigned char>(off + (nA + 1)*W*sizeof(cost_type));
+        size_t *DA = reinterpret_cast<size_t*>(p);
+        cost_type *H = reinterpret_cast<cost_type*>(p + off);
+        for (size_t j = 0; j <= nB; ++j) {
+          H[j] = cost_type(j)*I;
+          DA[j] = 0;
+        }
+
+        for (size_t i = 1; i <= nA; ++i) {
+          cost_type *Hi = H + i*W, *Hi1 = Hi - W;
+          Hi[0] = cost_type(i)*D;
+          CharT a = A[i-1];
+          // the last column j1 before this one at which B[j1-1] = A[i-1]
+          size_t DB = 0;
+          for (size_t j = 1; j <= nB; ++j) {
+            CharT b = B[j-1];
+            size_t i1 = DA[j], j1 = DB;
+            cost_type h;
+            if (a == b) {
+              h = Hi1[j-1];
+              DB = j;
+              DA[j] = i;
+            } else {
+              h = Hi1[j-1] + costs.substitution(a, b);
+            }
+            h = min(h, Hi[j-1] + I);
+            h = min(h, Hi1[j] + D);
+            if (i1 > 0 && j1 > 0) {
+              // Delete A[i1..i-2], swap A[i1-1] with A[i-1], & insert
+              // B[j1..j-2] between them
+              h = min(h, H[(i1-1)*W + j1-1] + cost_type(i - i1 - 1)*D +
+                      costs.transposition(A[i1-1], a) +
+                      cost_type(j - j1 - 1)*I);
+            }
+            Hi[j] = h;
+          }
+        }
+
+        return H[nA*W + nB];
+      }
+    }
+
+  } // namespace detail
+
+  /**
+   * \brief Compute the weighted Damerau-Levenshtein distance between two
+   * strings using the algorithm of Lowrance & Wagner (1975)
+   *
+   *
+   * \param A [in] the first of the two strings to be compared
+   *
+   * \param B [in] the second of the two strings to be compared
+   *
+   * \param costs [in] the cost policy (see costs.hh)
+   *
+   * \return the least cost, under \a costs, of a sequence of edits turning
+   * \a A into \a B
+   *
+   *
+   * Lowrance & Wagner's recurrence is the one algorithm here that can be
+   * weighted (see costs.hh). With dl::unit_costs, this is just
+   * lowrance_wagner(A, B), & compiles down to it; with any other policy, the
+   * full (m+1) x (n+1) matrix is kept (as cost_type), so it is meant for
+   * strings of modest length.
+   *
+   *
+   */
+
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::string_view A,
+                  std::string_view B,
+                  const Costs &costs)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs,
+                                            this_thread_workspace());
+  }
+
+  /// Compute the weighted Damerau-Levenshtein distance between \a A & \a B
+  /// under \a costs, in the workspace \a ws
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::string_view A,
+                  std::string_view B,
+                  const Costs &costs,
+                  workspace &ws)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs, ws);
+  }
+
+  /// As above, for strings of 16-bit characters
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::u16string_view A,
+                  std::u16string_view B,
+                  const Costs &costs)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs,
+                                            this_thread_workspace());
+  }
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::u16string_view A,
+                  std::u16string_view B,
+                  const Costs &costs,
+                  workspace &ws)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs, ws);
+  }
+
+  /// As above, for strings of 32-bit characters
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::u32string_view A,
+                  std::u32string_view B,
+                  const Costs &costs)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs,
+                                            this_thread_workspace());
+  }
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  template <typename Costs>
+  typename Costs::cost_type
+  lowrance_wagner(std::u32string_view A,
+                  std::u32string_view B,
+                  const Costs &costs,
+                  workspace &ws)
+  {
+    return detail::weighted_lowrance_wagner(A, B, costs, ws);
+  }
+
+} // namespace dl
+
 #endif // LW_H_INCLUDED
@@ -0,0 +1,396 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "lw_simd.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(HAVE_IMMINTRIN_H) && defined(__GNUC__) && \
+  (defined(__x86_64__) || defined(__i386__))
+# define DL_X86_SIMD 1
+# include <immintrin.h>
+#endif
+
+namespace {
+
+  /// Instruction sets for which we have a kernel, in increasing order of
+  /// preference
+  enum class isa { none, sse41, avx2 };
+
+  isa
+  detect_isa()
+  {
+    isa best = isa::none;
+#   ifdef DL_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      best = isa::avx2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+      best = isa::sse41;
+    }
+#   endif
+    if (const char *env = getenv("DL_SIMD")) {
+      isa cap = best;
+      if (0 == strcmp(env, "none")) {
+        cap = isa::none;
+      } else if (0 == strcmp(env, "sse4.1")) {
+        cap = isa::sse41;
+      } else if (0 == strcmp(env, "avx2")) {
+        cap = isa::avx2;
+      }
+      if (cap < best) best = cap;
+    }
+    return best;
+  }
+
+  isa
+  the_isa()
+  {
+    static const isa x = detect_isa();
+    return x;
+  }
+
+  /// Below this length, anti-diagonals are too short to fill a vector often
+  /// enough to pay for the set-up
+  const std::size_t MIN_LENGTH = 64;
+
+  /// Above this many cells (64MB of them), the kernel's full matrix isn't
+  /// worth its memory; the scalar implementation's tiles need only linear
+  /// space & are within a factor of two of it
+  const std::size_t MAX_CELLS = std::size_t(1) << 24;
+
+  /// Everything the kernels need, carved out of a workspace
+  struct tables {
+    std::size_t nA, nB;
+    /// A, and B reversed (so that, along an anti-diagonal, both are read in
+    /// increasing order); A[-1] & Brev[nB] are padding, so that the
+    /// neighbours of any character may be loaded without bounds checks
+    const unsigned char *A, *Brev;
+    /// For each character in A, the offset of its row in `lastB'; for each in
+    /// B (reversed), that of its row in `lastA'
+    const std::int32_t *rowA, *rowBrev;
+    /// lastA[c*(nA+1) + i] is the largest x <= i-1 such that A[x-1] = c
+    /// (zero if there is none), & lastB[c*(nB+1) + j] is the largest y <= j-1
+    /// such that B[y-1] = c; c is a dense code for the characters appearing in
+    /// both strings, with code zero (for all others) mapping to zero
+    const std::int32_t *lastA, *lastB;
+    /// H(i,j) is at H[base[i+j] + i]
+    const std::int32_t *base;
+    std::int32_t *H;
+  };
+
+  void
+  prepare(std::string_view A,
+          std::string_view B,
+          dl::workspace &ws,
+          tables &t)
+  {
+    using namespace std;
+
+    size_t nA = A.length(), nB = B.length();
+
+    // Only characters appearing in both strings can take part in a
+    // transposition
+    bool inA[256] = { false }, inB[256] = { false };
+    for (unsigned char c: A) inA[c] = true;
+    for (unsigned char c: B) inB[c] = true;
+    int32_t code[256], s = 0;
+    for (size_t c = 0; c < 256; ++c) {
+      code[c] = inA[c] && inB[c] ? ++s : 0;
+    }
+
+    // Lay out the tables in the workspace, each on its own cache line
+    size_t ncells = (nA + 1)*(nB + 1);
+    size_t sizes[] = {
+      nA + 1,                            // A (padded)
+      nB + 1,                            // Brev (padded)
+      nA*sizeof(int32_t),                // rowA
+      nB*sizeof(int32_t),                // rowBrev
+      (s + 1)*(nA + 1)*sizeof(int32_t),  // lastA
+      (s + 1)*(nB + 1)*sizeof(int32_t),  // lastB
+      (nA + nB + 1)*sizeof(int32_t),     // base
+      ncells*sizeof(int32_t)             // H
+    };
+    const size_t NUM = sizeof(sizes)/sizeof(sizes[0]);
+    size_t offsets[NUM], total = 0;
+    for (size_t i = 0; i < NUM; ++i) {
+      offsets[i] = total;
+      total += (sizes[i] + dl::workspace::ALIGNMENT - 1) /
+        dl::workspace::ALIGNMENT * dl::workspace::ALIGNMENT;
+    }
+    unsigned char *p = ws.reserve<unsigned char>(total);
+
+    unsigned char *Apad = p + offsets[0];
+    unsigned char *Brev = p + offsets[1];
+    int32_t *rowA    = (int32_t*)(p + offsets[2]);
+    int32_t *rowBrev = (int32_t*)(p + offsets[3]);
+    int32_t *lastA   = (int32_t*)(p + offsets[4]);
+    int32_t *lastB   = (int32_t*)(p + offsets[5]);
+    int32_t *base    = (int32_t*)(p + offsets[6]);
+
+    Apad[0] = 0;
+    memcpy(Apad + 1, A.data(), nA);
+    Brev[nB] = 0;
+    for (size_t k = 0; k < nB; ++k) {
+      Brev[k] = B[nB - 1 - k];
+      rowBrev[k] = code[Brev[k]]*(int32_t)(nA + 1);
+    }
+    for (size_t i = 0; i < nA; ++i) {
+      rowA[i] = code[(unsigned char)A[i]]*(int32_t)(nB + 1);
+    }
+
+    memset(lastA, 0, (nA + 1)*sizeof(int32_t));
+    for (int32_t c = 1; c <= s; ++c) {
+      int32_t *row = lastA + c*(nA + 1);
+      row[0] = 0;
+      for (size_t i = 1; i <= nA; ++i) {
+        row[i] = i >= 2 && code[(unsigned char)A[i-2]] == c ? i - 1 : row[i-1];
+      }
+    }
+    memset(lastB, 0, (nB + 1)*sizeof(int32_t));
+    for (int32_t c = 1; c <= s; ++c) {
+      int32_t *row = lastB + c*(nB + 1);
+      row[0] = 0;
+      for (size_t j = 1; j <= nB; ++j) {
+        row[j] = j >= 2 && code[(unsigned char)B[j-2]] == c ? j - 1 : row[j-1];
+      }
+    }
+
+    int32_t offset = 0;
+    for (size_t d = 0; d <= nA + nB; ++d) {
+      size_t ilo = d > nB ? d - nB : 0, ihi = min(nA, d);
+      base[d] = offset - (int32_t)ilo;
+      offset += ihi - ilo + 1;
+    }
+
+    t.nA = nA;
+    t.nB = nB;
+    t.A = Apad + 1;
+    t.Brev = Brev;
+    t.rowA = rowA;
+    t.rowBrev = rowBrev;
+    t.lastA = lastA;
+    t.lastB = lastB;
+    t.base = base;
+    t.H = (int32_t*)(p + offsets[7]);
+  }
+
+  /// Fill-in the cells of anti-diagonal d lying in the first row & column
+  inline void
+  boundaries(const tables &t,
+             std::size_t d)
+  {
+    if (d <= t.nB) t.H[t.base[d]] = d;     // H(0,d)
+    if (d <= t.nA) t.H[t.base[d] + d] = d; // H(d,0)
+  }
+
+  /// Apply the transposition term to H(i,d-i)
+  ///
+  /// H(i-1,j-1) is at most H(i1-1,j1-1) + max(i-i1,j-j1), so the transposition
+  /// term can only beat h1 when i1 = i-1 or j1 = j-1; that is, when A[i-2] =
+  /// B[j-1] or A[i-1] = B[j-2]. Furthermore, since adjacent cells in a row or
+  /// column differ by at most one, in either case it's at least H(i-2,j-2) +
+  /// 1. The kernels test for both conditions with contiguous loads & only come
+  /// here for the (few) lanes that pass.
+  inline std::int32_t
+  transpose(const tables &t,
+            std::size_t d,
+            std::size_t i,
+            std::int32_t h)
+  {
+    std::size_t j = d - i, kb = t.nB - j; // B[j-1] is Brev[kb]
+    std::int32_t i1 = t.lastA[t.rowBrev[kb] + i];
+    std::int32_t j1 = t.lastB[t.rowA[i-1] + j];
+    if (i1 > 0 && j1 > 0) {
+      std::int32_t h4 = t.H[t.base[i1 - 1 + j1 - 1] + i1 - 1] + d - i1 - j1 - 1;
+      if (h4 < h) h = h4;
+    }
+    return h;
+  }
+
+  /// Compute H(i,d-i), for 1 <= i <= nA & 1 <= d-i <= nB
+  inline std::int32_t
+  cell(const tables &t,
+       std::size_t d,
+       std::size_t i)
+  {
+    std::size_t kb = t.nB - (d - i);
+    const std::int32_t *H = t.H, *base = t.base;
+    std::int32_t h = H[base[d-2] + i - 1] + (t.A[i-1] != t.Brev[kb]);
+    std::int32_t h2 = H[base[d-1] + i] + 1;
+    std::int32_t h3 = H[base[d-1] + i - 1] + 1;
+    if (h2 < h) h = h2;
+    if (h3 < h) h = h3;
+    if (t.A[i-2] == t.Brev[kb] || t.A[i-1] == t.Brev[kb+1]) {
+      h = transpose(t, d, i, h);
+    }
+    return h;
+  }
+
+# ifdef DL_X86_SIMD
+
+  __attribute__((target("avx2")))
+  void
+  kernel_avx2(const tables &t)
+  {
+    using namespace std;
+
+    const size_t nA = t.nA, nB = t.nB;
+    const __m256i one = _mm256_set1_epi32(1);
+
+    for (size_t d = 2; d <= nA + nB; ++d) {
+      boundaries(t, d);
+      size_t i = d > nB + 1 ? d - nB : 1, iend = min(nA, d - 1);
+      const int32_t *Hm2 = t.H + t.base[d-2], *Hm1 = t.H + t.base[d-1];
+      int32_t *Hd = t.H + t.base[d];
+      // The cells in the second row & column are done in scalar, so that the
+      // vector loop may always reach back to H(i-2,j-2)
+      if (1 == i) {
+        Hd[i] = cell(t, d, i);
+        ++i;
+      }
+      size_t vend = d - 1 == iend ? iend - 1 : iend;
+      const int32_t *Hm4 = d >= 4 ? t.H + t.base[d-4] : nullptr;
+      for ( ; i + 7 <= vend; i += 8) {
+        size_t kb = nB - (d - i);
+        // h1, h2 & h3 in the scalar version
+        __m256i h1 = _mm256_loadu_si256((const __m256i*)(Hm2 + i - 1));
+        __m256i h2 = _mm256_loadu_si256((const __m256i*)(Hm1 + i));
+        __m256i h3 = _mm256_loadu_si256((const __m256i*)(Hm1 + i - 1));
+        __m256i a  = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(t.A + i - 1)));
+        __m256i ap = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(t.A + i - 2)));
+        __m256i b  = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(t.Brev + kb)));
+        __m256i bp = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(t.Brev + kb + 1)));
+        __m256i h = _mm256_add_epi32(h1, _mm256_andnot_si256(_mm256_cmpeq_epi32(a, b), one));
+        h = _mm256_min_epi32(h, _mm256_add_epi32(_mm256_min_epi32(h2, h3), one));
+        _mm256_storeu_si256((__m256i*)(Hd + i), h);
+        __m256i h22 = _mm256_loadu_si256((const __m256i*)(Hm4 + i - 2));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi32(ap, b), _mm256_cmpeq_epi32(a, bp)),
+          _mm256_cmpgt_epi32(h, _mm256_add_epi32(h22, one)))));
+        while (mask) {
+          size_t k = __builtin_ctz(mask);
+          Hd[i + k] = transpose(t, d, i + k, Hd[i + k]);
+          mask &= mask - 1;
+        }
+      }
+      for ( ; i <= iend; ++i) {
+        Hd[i] = cell(t, d, i);
+      }
+    }
+  }
+
+  __attribute__((target("sse4.1")))
+  inline __m128i
+  load4_epu8_sse41(const unsigned char *p)
+  {
+    std::int32_t x;
+    memcpy(&x, p, sizeof(x));
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(x));
+  }
+
+  __attribute__((target("sse4.1")))
+  void
+  kernel_sse41(const tables &t)
+  {
+    using namespace std;
+
+    const size_t nA = t.nA, nB = t.nB;
+    const __m128i one = _mm_set1_epi32(1);
+
+    for (size_t d = 2; d <= nA + nB; ++d) {
+      boundaries(t, d);
+      size_t i = d > nB + 1 ? d - nB : 1, iend = min(nA, d - 1);
+      const int32_t *Hm2 = t.H + t.base[d-2], *Hm1 = t.H + t.base[d-1];
+      int32_t *Hd = t.H + t.base[d];
+      // The cells in the second row & column are done in scalar, so that the
+      // vector loop may always reach back to H(i-2,j-2)
+      if (1 == i) {
+        Hd[i] = cell(t, d, i);
+        ++i;
+      }
+      size_t vend = d - 1 == iend ? iend - 1 : iend;
+      const int32_t *Hm4 = d >= 4 ? t.H + t.base[d-4] : nullptr;
+      for ( ; i + 3 <= vend; i += 4) {
+        size_t kb = nB - (d - i);
+        __m128i h1 = _mm_loadu_si128((const __m128i*)(Hm2 + i - 1));
+        __m128i h2 = _mm_loadu_si128((const __m128i*)(Hm1 + i));
+        __m128i h3 = _mm_loadu_si128((const __m128i*)(Hm1 + i - 1));
+        __m128i a  = load4_epu8_sse41(t.A + i - 1);
+        __m128i ap = load4_epu8_sse41(t.A + i - 2);
+        __m128i b  = load4_epu8_sse41(t.Brev + kb);
+        __m128i bp = load4_epu8_sse41(t.Brev + kb + 1);
+        __m128i h = _mm_add_epi32(h1, _mm_andnot_si128(_mm_cmpeq_epi32(a, b), one));
+        h = _mm_min_epi32(h, _mm_add_epi32(_mm_min_epi32(h2, h3), one));
+        _mm_storeu_si128((__m128i*)(Hd + i), h);
+        __m128i h22 = _mm_loadu_si128((const __m128i*)(Hm4 + i - 2));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(
+          _mm_or_si128(_mm_cmpeq_epi32(ap, b), _mm_cmpeq_epi32(a, bp)),
+          _mm_cmpgt_epi32(h, _mm_add_epi32(h22, one)))));
+        while (mask) {
+          size_t k = __builtin_ctz(mask);
+          Hd[i + k] = transpose(t, d, i + k, Hd[i + k]);
+          mask &= mask - 1;
+        }
+      }
+      for ( ; i <= iend; ++i) {
+        Hd[i] = cell(t, d, i);
+      }
+    }
+  }
+
+# endif // DL_X86_SIMD
+
+}
+
+bool
+dl::detail::lowrance_wagner_simd_ok(std::size_t nA,
+                                    std::size_t nB)
+{
+  using namespace std;
+  // Every index into the tables must fit in 32 bits
+  const size_t MAX_INDEX = numeric_limits<int32_t>::max();
+  return isa::none != the_isa() &&
+    min(nA, nB) >= MIN_LENGTH &&
+    (nA + 1) <= MAX_CELLS / (nB + 1) &&
+    (nA + 1) <= MAX_INDEX / (nB + 1) &&
+    max(nA, nB) + 1 <= MAX_INDEX / 257;
+}
+
+std::size_t
+dl::detail::lowrance_wagner_simd(std::string_view A,
+                                 std::string_view B,
+                                 workspace &ws)
+{
+  tables t;
+  prepare(A, B, ws, t);
+
+  t.H[0] = 0;
+  boundaries(t, 1);
+# ifdef DL_X86_SIMD
+  if (isa::avx2 == the_isa()) {
+    kernel_avx2(t);
+  } else {
+    kernel_sse41(t);
+  }
+# endif
+
+  return t.H[t.base[t.nA + t.nB] + t.nA];
+}
@@ -0,0 +1,96 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef LW_SIMD_HH_INCLUDED
+#define LW_SIMD_HH_INCLUDED 1
+
+#include "workspace.hh"
+
+#include <cstddef>
+#include <string_view>
+
+namespace dl {
+
+  namespace detail {
+
+    /**
+     * \brief Determine whether lowrance_wagner_simd can be used for a given
+     * pair of strings
+     *
+     *
+     * \param nA [in] the length of the first string
+     *
+     * \param nB [in] the length of the second string
+     *
+     * \return true if the CPU on which we're running supports one of the
+     * instruction sets for which a vectorized kernel is available, and the
+     * strings are long enough to make it worthwhile (and short enough that
+     * the full recurrence relation, at four bytes per cell, occupies no more
+     * than 64MB; beyond that, the scalar implementation's linear space wins)
+     *
+     *
+     * The instruction set is detected once, on first call. Setting the
+     * environment variable DL_SIMD to "none", "sse4.1" or "avx2" caps the
+     * instruction set used (which is chiefly useful for testing).
+     *
+     *
+     */
+
+    bool
+    lowrance_wagner_simd_ok(std::size_t nA,
+                            std::size_t nB);
+
+    /**
+     * \brief Compute the Damerau-Levenshtein distance between two strings
+     * using the recurrence relation of Lowrance & Wagner, evaluated one
+     * anti-diagonal at a time with SIMD instructions
+     *
+     *
+     * \pre lowrance_wagner_simd_ok(A.length(), B.length())
+     *
+     *
+     * Along a row of the recurrence relation, each cell depends on its
+     * predecessor, which defeats vectorization. The cells on an anti-diagonal
+     * (i + j = d), however, depend only on cells on the previous two
+     * anti-diagonals (save for the transposition term, on which more below), so
+     * they may be computed eight (AVX2) or four (SSE4.1) at a time. This
+     * implementation stores the matrix anti-diagonal by anti-diagonal, so that
+     * H(i-1,j-1), H(i,j-1) & H(i-1,j) are each a contiguous load.
+     *
+     * The transposition term reaches back to H(i1-1,j1-1), where i1 is the
+     * last row before i at which B[j] appears in A (DA in the scalar
+     * version) & j1 the last column before j at which A[i] appears in B (DB).
+     * Since DA & DB are built up as the scalar version sweeps the matrix, they
+     * are instead pre-computed into tables indexed by character & position.
+     * Gathering from those tables for every lane would be slow, but the
+     * transposition term can only lower a cell when A[i-1] = B[j] or A[i] =
+     * B[j-1] (& H(i-2,j-2) is small enough), which the kernel tests for with
+     * contiguous loads; the few cells that pass are finished in scalar code.
+     *
+     * The result is identical to that of the scalar implementation.
+     *
+     *
+     */
+
+    std::size_t
+    lowrance_wagner_simd(std::string_view A,
+                         std::string_view B,
+                         workspace &ws);
+
+  } // namespace detail
+
+} // namespace dl
+
+#endif // LW_SIMD_HH_INCLUDED
@@ -0,0 +1,244 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef LW_TILES_HH_INCLUDED
+#define LW_TILES_HH_INCLUDED 1
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+namespace dl {
+
+  namespace detail {
+
+    /// The number of rows in each tile of the recurrence relation
+    const std::size_t TILE_ROWS = 64;
+    /// The number of columns in each tile of the recurrence relation
+    const std::size_t TILE_COLS = 256;
+
+    /**
+     * \brief The state carried between the tiles of the recurrence relation
+     *
+     *
+     * The recurrence is evaluated a tile of TILE_ROWS x TILE_COLS cells at a
+     * time, each tile once those above & to the left of it are complete (row
+     * by row, or along anti-diagonals on several threads; see
+     * dl::parallel_wavefront). Within a tile, only the last three rows are kept
+     * (in a buffer of 3 * (TILE_COLS + 2) words supplied by the caller); what
+     * a tile needs from its neighbours (& leaves for them) is held here. In
+     * all, that's O(nA + nB) words. Each part of it belongs to a single row or
+     * column of tiles, whose tiles are computed in order, so tiles on the same
+     * anti-diagonal never touch the same state.
+     *
+     * h1, h2 & h3 need only the two rows above & the two columns to the left
+     * of each tile, but h4 reaches back to H(i1-1,j1-1), which may be any
+     * number of rows & columns back. Happily, it can only matter when i1 =
+     * i-1 or j1 = j-1: writing a = i - i1 & b = j - j1, we have H(i-1,j-1) <=
+     * H(i1-1,j1-1) + max(a,b) (edit A[i1-1..i-2] into B[j1-1..j-2] one
+     * character at a time), so
+     *
+     \code
+
+       h4 = H(i1-1,j1-1) + a + b - 1 >= H(i-1,j-1) + min(a,b) - 1
+
+     \endcode
+     *
+     * which, if a & b both exceed one, is no less than h1. When i1 = i-1, h4
+     * reads row i-2 at column j1-1; when j1 = j-1, it reads column j-2 at row
+     * i1-1. So it suffices to keep, for each row, the last column j1 at which
+     * B[j1-1] = A[i-1] together with H(i-2,j1-1), & for each column, the last
+     * row i1 at which A[i1-1] = B[j-1] together with H(i1-1,j-2). This also
+     * does away with the per-character table DA.
+     *
+     *
+     */
+
+    struct tiling {
+      std::size_t nA, nB, INF;
+      /// The number of tiles in each column & in each row
+      std::size_t num_rows, num_cols;
+      /// H(i0-2,j) & H(i0-1,j) for each column j, where i0 is the first row of
+      /// the next tile to be computed in that column
+      std::size_t *top0, *top1;
+      /// For each column j, the last row i1 at which A[i1-1] = B[j-1], &
+      /// H(i1-1,j-2)
+      std::size_t *col_i1, *col_h;
+      /// For each row i, the last column j1 at which B[j1-1] = A[i-1], &
+      /// H(i-2,j1-1)
+      std::size_t *row_j1, *row_h;
+      /// The minimum over each row, so far
+      std::size_t *row_min;
+      /// For each row of tiles, the last two columns of the tile most recently
+      /// computed therein, as pairs, from two rows above the tile to its last
+      /// row
+      std::size_t *left;
+
+      /// Return the number of words needed to compare strings of lengths \a nA
+      /// & \a nB
+      static std::size_t words(std::size_t nA, std::size_t nB) {
+        std::size_t num_rows = (nA + TILE_ROWS - 1) / TILE_ROWS;
+        return 4*(nB + 1) + 3*(nA + 1) + num_rows*2*(TILE_ROWS + 2);
+      }
+
+      /// Carve the state out of the \a words(nA, nB) words at \a p & initialize
+      /// it
+      tiling(std::size_t nA, std::size_t nB, std::size_t *p):
+        nA(nA), nB(nB), INF(nA + nB + 1),
+        num_rows((nA + TILE_ROWS - 1) / TILE_ROWS),
+        num_cols((nB + TILE_COLS - 1) / TILE_COLS)
+      {
+        top0 = p; p += nB + 1;
+        top1 = p; p += nB + 1;
+        col_i1 = p; p += nB + 1;
+        col_h = p; p += nB + 1;
+        row_j1 = p; p += nA + 1;
+        row_h = p; p += nA + 1;
+        row_min = p; p += nA + 1;
+        left = p;
+        for (std::size_t j = 0; j <= nB; ++j) {
+          top0[j] = INF;
+          top1[j] = j;
+          col_i1[j] = 0;
+        }
+        for (std::size_t i = 0; i <= nA; ++i) {
+          row_j1[i] = 0;
+          row_min[i] = i;
+        }
+      }
+    };
+
+    /**
+     * \brief Compute one tile of the recurrence relation
+     *
+     *
+     * \param t [in,out] the state carried between tiles; the tiles above & to
+     * the left of this one must be complete
+     *
+     * \param I [in] the row of the tile to be computed
+     *
+     * \param J [in] the column of the tile to be computed
+     *
+     * \param buf [in] scratch space of 3 * (TILE_COLS + 2) words
+     *
+     * \param max_k [in] the largest distance of interest
+     *
+     * \return false if this tile lies in the last column & the minimum over
+     * one of its rows exceeds \a max_k (in which case, so must the distance),
+     * true otherwise
+     *
+     *
+     */
+
+    template <typename CharT>
+    bool
+    tile(const tiling &t,
+         std::basic_string_view<CharT> A,
+         std::basic_string_view<CharT> B,
+         std::size_t I,
+         std::size_t J,
+         std::size_t *buf,
+         std::size_t max_k)
+    {
+      using namespace std;
+
+      const size_t INF = t.INF;
+      size_t i0 = 1 + I*TILE_ROWS, i_end = min(i0 + TILE_ROWS, t.nA + 1);
+      size_t j0 = 1 + J*TILE_COLS, j_end = min(j0 + TILE_COLS, t.nB + 1);
+      size_t W = j_end - j0 + 2;
+      bool last = j_end == t.nB + 1;
+      // The two columns to the left of this tile (& the corner above it) are
+      // found in `left', as pairs, at r = i - i0 + 2; on the left edge of the
+      // matrix, they're known.
+      size_t *L = t.left + I*2*(TILE_ROWS + 2);
+      if (0 == J) {
+        for (size_t r = 0; r < i_end - i0 + 2; ++r) {
+          L[2*r] = INF;
+          L[2*r + 1] = 0 == i0 + r - 1 ? INF : i0 + r - 2;
+        }
+      }
+
+      // Load the two rows above the tile (buf[0] & buf[1])...
+      size_t *Hr2 = buf, *Hr1 = buf + W, *Hr = buf + 2*W;
+      copy(t.top0 + j0, t.top0 + j_end, Hr2 + 2);
+      copy(t.top1 + j0, t.top1 + j_end, Hr1 + 2);
+      for (size_t r = 0; r < 2; ++r) {
+        size_t *H = 0 == r ? Hr2 : Hr1;
+        H[0] = L[2*r];
+        H[1] = L[2*r + 1];
+        L[2*r] = H[W - 2];
+        L[2*r + 1] = H[W - 1];
+      }
+
+      // & compute the tile a row at a time.
+      for (size_t i = i0, r = 2; i < i_end; ++i, ++r) {
+        CharT a = A[i-1];
+        bool has_ap = i >= 2;
+        CharT ap = has_ap ? A[i-2] : a;
+        size_t j1 = t.row_j1[i], h_j1 = t.row_h[i];
+        size_t row_min = t.row_min[i];
+        Hr[0] = L[2*r];
+        Hr[1] = L[2*r + 1];
+        for (size_t c = 2, j = j0; j < j_end; ++c, ++j) {
+          CharT b = B[j-1];
+          // i1 = i - 1
+          bool i1_adj = has_ap && ap == b;
+          if (i1_adj) {
+            t.col_i1[j] = i - 1;
+            t.col_h[j] = Hr2[c-2];
+          }
+          size_t h;
+          if (a == b) {
+            h = Hr1[c-1];
+            j1 = j;
+            h_j1 = Hr2[c-1];
+          } else {
+            h = min(min(Hr1[c-1], Hr[c-1]), Hr1[c]) + 1;
+            if (i1_adj) {
+              if (j1 > 0) {
+                h = min(h, h_j1 + (j - j1));
+              }
+            } else if (j1 == j - 1 && t.col_i1[j] > 0) {
+              h = min(h, t.col_h[j] + (i - t.col_i1[j]));
+            }
+          }
+          Hr[c] = h;
+          if (h < row_min) row_min = h;
+        }
+        t.row_j1[i] = j1;
+        t.row_h[i] = h_j1;
+        t.row_min[i] = row_min;
+        L[2*r] = Hr[W - 2];
+        L[2*r + 1] = Hr[W - 1];
+        if (last && row_min > max_k) {
+          return false;
+        }
+        size_t *tmp = Hr2;
+        Hr2 = Hr1;
+        Hr1 = Hr;
+        Hr = tmp;
+      }
+
+      // Finally, leave the last two rows for the tile below.
+      copy(Hr2 + 2, Hr2 + W, t.top0 + j0);
+      copy(Hr1 + 2, Hr1 + W, t.top1 + j0);
+      return true;
+    }
+
+  } // namespace detail
+
+} // namespace dl
+
+#endif // LW_TILES_HH_INCLUDED
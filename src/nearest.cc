@@ -0,0 +1,171 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "nearest.hh"
+#include "br.hh"
+#include "filter.hh"
+#include "parallel.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+
+namespace {
+
+  /// Order matches by distance, then by position; the top of a heap so
+  /// ordered is the worst match in it
+  bool
+  closer(const dl::match &a, const dl::match &b)
+  {
+    return a.distance < b.distance ||
+      (a.distance == b.distance && a.index < b.index);
+  }
+
+  template <typename CharT>
+  std::vector<dl::match>
+  nearest(std::basic_string_view<CharT> q,
+          const std::vector<std::basic_string_view<CharT>> &C,
+          std::size_t n,
+          std::size_t max_k,
+          unsigned num_threads,
+          bool length_order,
+          dl::search_stats *stats)
+  {
+    using namespace std;
+
+    typedef basic_string_view<CharT> view_type;
+
+    size_t m = C.size(), nq = q.length();
+    auto length_diff = [nq](view_type b) {
+      return b.length() > nq ? b.length() - nq : nq - b.length();
+    };
+
+    // Put the candidates in the order in which they're to be examined...
+    vector<size_t> order(m);
+    if (length_order) {
+      size_t max_diff = 0;
+      for (view_type b: C) {
+        max_diff = max(max_diff, length_diff(b));
+      }
+      vector<size_t> start(max_diff + 2, 0);
+      for (view_type b: C) {
+        ++start[length_diff(b) + 1];
+      }
+      partial_sum(start.begin(), start.end(), start.begin());
+      for (size_t i = 0; i < m; ++i) {
+        order[start[length_diff(C[i])]++] = i;
+      }
+    } else {
+      iota(order.begin(), order.end(), size_t(0));
+    }
+
+    // & examine them, each against the bound in effect at the time. The
+    // bound is read without the lock; it only ever shrinks, so a stale value
+    // merely costs a little work.
+    vector<dl::match> H;
+    H.reserve(min(n, m));
+    mutex mtx;
+    atomic<size_t> bound(0 == n ? 0 : max_k);
+    if (0 == num_threads) num_threads = 1;
+    vector<dl::workspace> WS(num_threads - 1);
+    vector<size_t> evaluations(num_threads, 0);
+    dl::parallel_for(0 == n ? 0 : m, 256, num_threads,
+                     [&](unsigned w, size_t, size_t i0, size_t i1) {
+      dl::workspace &ws = 0 == w ? dl::this_thread_workspace() : WS[w - 1];
+      for (size_t j = i0; j < i1; ++j) {
+        size_t i = order[j], k = bound.load(memory_order_relaxed);
+        view_type a = q, b = C[i];
+        if (length_diff(b) > k) {
+          // In length order, so is every other candidate in this chunk
+          if (length_order) break;
+          continue;
+        }
+        size_t d;
+        if (!dl::prefilter(a, b, k, d)) {
+          d = numeric_limits<size_t>::max() == k ?
+            dl::berghel_roach(a, b, ws) :
+            dl::berghel_roach_within(a, b, k, ws);
+          ++evaluations[w];
+        }
+        if (d > k) {
+          continue;
+        }
+        dl::match x{i, d};
+        lock_guard<mutex> lock(mtx);
+        if (H.size() < n) {
+          H.push_back(x);
+          push_heap(H.begin(), H.end(), closer);
+        } else if (closer(x, H.front())) {
+          pop_heap(H.begin(), H.end(), closer);
+          H.back() = x;
+          push_heap(H.begin(), H.end(), closer);
+        } else {
+          continue;
+        }
+        if (H.size() == n) {
+          bound.store(H.front().distance, memory_order_relaxed);
+        }
+      }
+    });
+
+    sort_heap(H.begin(), H.end(), closer);
+    if (stats) {
+      ++stats->queries;
+      stats->evaluations += accumulate(evaluations.begin(), evaluations.end(),
+                                       size_t(0));
+      stats->entries += m;
+    }
+    return H;
+  }
+
+}
+
+std::vector<dl::match>
+dl::nearest(std::string_view q,
+            const std::vector<std::string_view> &C,
+            std::size_t n,
+            std::size_t max_k,
+            unsigned num_threads,
+            bool length_order,
+            search_stats *stats)
+{
+  return ::nearest(q, C, n, max_k, num_threads, length_order, stats);
+}
+
+std::vector<dl::match>
+dl::nearest(std::u16string_view q,
+            const std::vector<std::u16string_view> &C,
+            std::size_t n,
+            std::size_t max_k,
+            unsigned num_threads,
+            bool length_order,
+            search_stats *stats)
+{
+  return ::nearest(q, C, n, max_k, num_threads, length_order, stats);
+}
+
+std::vector<dl::match>
+dl::nearest(std::u32string_view q,
+            const std::vector<std::u32string_view> &C,
+            std::size_t n,
+            std::size_t max_k,
+            unsigned num_threads,
+            bool length_order,
+            search_stats *stats)
+{
+  return ::nearest(q, C, n, max_k, num_threads, length_order, stats);
+}
@@ -0,0 +1,110 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef NEAREST_HH_INCLUDED
+#define NEAREST_HH_INCLUDED 1
+
+#include "query.hh"
+
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /**
+   * \brief Find the candidates nearest a query
+   *
+   *
+   * \param q [in] the query
+   *
+   * \param C [in] the candidates
+   *
+   * \param n [in] the number of candidates wanted
+   *
+   * \param max_k [in] the largest distance of interest; candidates further
+   * than this from \a q are never returned (by default, there is no limit)
+   *
+   * \param num_threads [in] the number of threads over which to spread the
+   * candidates (including the calling thread)
+   *
+   * \param length_order [in] if true, examine the candidates in order of the
+   * difference between their lengths & that of \a q (see below)
+   *
+   * \param stats [in,out] if non-null, the cost of this search (in calls to
+   * dl::berghel_roach_within) will be added to it
+   *
+   * \return the \a n candidates nearest \a q (or all of them, if there are
+   * fewer than \a n within \a max_k), closest first; each match's index is
+   * the candidate's position in \a C
+   *
+   *
+   * This is for the common case in which the caller doesn't know how close a
+   * match to expect, & so can't pick a k with which to search an index. The
+   * best \a n matches so far are kept in a max-heap. Once it's full, the
+   * distance at its top is the furthest a candidate can be & still make the
+   * cut, so each subsequent candidate is compared with
+   * dl::berghel_roach_within bounded by that distance, & gives up as soon as
+   * it's exceeded. As closer matches are found, the bound tightens.
+   *
+   * The difference in lengths between two strings is a lower bound on their
+   * distance. If \a length_order is set, the candidates are examined in order
+   * of that difference (by way of a counting sort), so that the closest
+   * matches tend to be found early, & once the difference exceeds the bound,
+   * every remaining candidate is discarded without being looked at.
+   *
+   * With more than one thread, the heap (& so the bound) is shared among the
+   * threads. The result doesn't depend on the number of threads, nor on
+   * \a length_order: among candidates equally distant from \a q, those
+   * earlier in \a C are preferred.
+   *
+   * The distances are restricted, as computed by Berghel & Roach.
+   *
+   *
+   */
+
+  std::vector<match>
+  nearest(std::string_view q,
+          const std::vector<std::string_view> &C,
+          std::size_t n,
+          std::size_t max_k = std::numeric_limits<std::size_t>::max(),
+          unsigned num_threads = 1,
+          bool length_order = true,
+          search_stats *stats = nullptr);
+
+  /// As above, for strings of 16-bit characters
+  std::vector<match>
+  nearest(std::u16string_view q,
+          const std::vector<std::u16string_view> &C,
+          std::size_t n,
+          std::size_t max_k = std::numeric_limits<std::size_t>::max(),
+          unsigned num_threads = 1,
+          bool length_order = true,
+          search_stats *stats = nullptr);
+
+  /// As above, for strings of 32-bit characters
+  std::vector<match>
+  nearest(std::u32string_view q,
+          const std::vector<std::u32string_view> &C,
+          std::size_t n,
+          std::size_t max_k = std::numeric_limits<std::size_t>::max(),
+          unsigned num_threads = 1,
+          bool length_order = true,
+          search_stats *stats = nullptr);
+
+} // namespace dl
+
+#endif // NEAREST_HH_INCLUDED
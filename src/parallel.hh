@@ -0,0 +1,316 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef PARALLEL_HH_INCLUDED
+#define PARALLEL_HH_INCLUDED 1
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dl {
+
+  /**
+   * \brief Apply a function to a range of indicies in chunks, on several
+   * threads, with work-stealing
+   *
+   *
+   * \param n [in] the number of indicies; \a f will be applied to [0, \a n)
+   *
+   * \param chunk [in] the number of indicies handed to \a f at a time
+   *
+   * \param num_threads [in] the number of threads to use (including the
+   * calling thread); if this is zero or one, \a f will simply be invoked on
+   * each chunk in order on the calling thread
+   *
+   * \param f [in] a callable that will be invoked as f(w, c, i0, i1), where w
+   * is the index of the worker thread invoking it (in [0, \a num_threads)), c
+   * the index of the chunk & [i0, i1) the indicies in that chunk
+   *
+   *
+   * The chunks are initially divided evenly among the workers, each of which
+   * works through its own share from the front. A worker that runs out of
+   * work steals chunks from the back of another's share, so that a few
+   * expensive chunks don't leave the other threads idle. Since each call to
+   * \a f is made on behalf of a single worker, callers can keep per-worker
+   * state (such as a workspace) in an array indexed by w.
+   *
+   * If \a f throws, the remaining workers finish (or abandon) their work & the
+   * first exception thrown is re-thrown on the calling thread.
+   *
+   * If some of the threads can't be started, the work is done on those that
+   * could (& the calling thread), & no error is reported.
+   *
+   *
+   */
+
+  template <typename F>
+  void
+  parallel_for(std::size_t n,
+               std::size_t chunk,
+               unsigned num_threads,
+               F f)
+  {
+    using namespace std;
+
+    if (0 == chunk) chunk = 1;
+    size_t num_chunks = (n + chunk - 1) / chunk;
+
+    if (num_threads <= 1 || num_chunks <= 1) {
+      for (size_t c = 0; c < num_chunks; ++c) {
+        f(0u, c, c * chunk, min(n, (c + 1) * chunk));
+      }
+      return;
+    }
+
+    // Each worker's share of the chunks is [head, tail); the owner takes
+    // from the head & thieves from the tail.
+    struct share {
+      mutex mtx;
+      size_t head, tail;
+    };
+    unique_ptr<share[]> shares(new share[num_threads]);
+    for (unsigned w = 0; w < num_threads; ++w) {
+      shares[w].head = w * num_chunks / num_threads;
+      shares[w].tail = (w + 1) * num_chunks / num_threads;
+    }
+
+    mutex ex_mtx;
+    exception_ptr ex;
+
+    auto worker = [&](unsigned w) {
+      for (;;) {
+        size_t c = num_chunks;
+        {
+          lock_guard<mutex> lock(shares[w].mtx);
+          if (shares[w].head < shares[w].tail) {
+            c = shares[w].head++;
+          }
+        }
+        for (unsigned i = 1; c == num_chunks && i < num_threads; ++i) {
+          share &victim = shares[(w + i) % num_threads];
+          lock_guard<mutex> lock(victim.mtx);
+          if (victim.head < victim.tail) {
+            c = --victim.tail;
+          }
+        }
+        if (c == num_chunks) {
+          return;
+        }
+        try {
+          f(w, c, c * chunk, min(n, (c + 1) * chunk));
+        } catch (...) {
+          lock_guard<mutex> lock(ex_mtx);
+          if (!ex) ex = current_exception();
+        }
+      }
+    };
+
+    vector<thread> threads;
+    threads.reserve(num_threads - 1);
+    try {
+      for (unsigned w = 1; w < num_threads; ++w) {
+        threads.emplace_back(worker, w);
+      }
+    } catch (...) {
+      // Couldn't start every thread; those that did start (with our help)
+      // will steal the shares of those that didn't, & see all the work
+      // through, so there's nothing to report.
+    }
+    worker(0);
+    for (auto &t: threads) {
+      t.join();
+    }
+
+    if (ex) {
+      rethrow_exception(ex);
+    }
+  }
+
+  /**
+   * \brief Apply a function to each cell of a grid, on several threads, each
+   * cell being processed only once the cells above it & to its left are done
+   *
+   *
+   * \param rows [in] the number of rows in the grid
+   *
+   * \param cols [in] the number of columns in the grid
+   *
+   * \param num_threads [in] the number of threads to use (including the
+   * calling thread); if this is zero or one, \a f will simply be invoked on
+   * each cell in row-major order on the calling thread
+   *
+   * \param f [in] a callable that will be invoked as f(w, I, J), where w is
+   * the index of the worker thread invoking it (in [0, \a num_threads)) & I &
+   * J the row & column of the cell; it shall return true to carry on, or
+   * false to abandon the cells not yet begun
+   *
+   * \return true if \a f returned true for every cell, false else
+   *
+   *
+   * This is the shape of a dynamic programming recurrence broken up into
+   * tiles: each tile depends on the one above & the one to its left, so the
+   * tiles on each anti-diagonal may be computed concurrently. Rather than
+   * compute the anti-diagonals one after another (with a barrier between
+   * each), every cell keeps a count of its unfinished predecessors. A worker
+   * finishing a cell decrements the counts of the cells below & to the right;
+   * one whose count reaches zero is ready. The worker carries straight on with
+   * one ready cell (preferring the one to the right, whose inputs it has just
+   * written) & queues the other for any idle worker, so that a worker only
+   * waits when there is nothing at all that may be done.
+   *
+   * Everything \a f writes for a cell is visible to the invocations of \a f
+   * for the cells below & to the right of it.
+   *
+   * If \a f throws, no further cells are begun & the first exception thrown
+   * is re-thrown on the calling thread.
+   *
+   * As with parallel_for, if some of the threads can't be started, the work
+   * is done on those that could (& the calling thread), & no error is
+   * reported.
+   *
+   *
+   */
+
+  template <typename F>
+  bool
+  parallel_wavefront(std::size_t rows,
+                     std::size_t cols,
+                     unsigned num_threads,
+                     F f)
+  {
+    using namespace std;
+
+    size_t num_cells = rows * cols;
+    if (num_threads <= 1 || num_cells <= 1) {
+      for (size_t I = 0; I < rows; ++I) {
+        for (size_t J = 0; J < cols; ++J) {
+          if (!f(0u, I, J)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    // The number of unfinished predecessors of each cell
+    typedef atomic<unsigned char> counter;
+    unique_ptr<counter[]> deps(new counter[num_cells]);
+    for (size_t I = 0, c = 0; I < rows; ++I) {
+      for (size_t J = 0; J < cols; ++J, ++c) {
+        deps[c].store((0 < I) + (0 < J), memory_order_relaxed);
+      }
+    }
+
+    mutex mtx;
+    condition_variable cv;
+    vector<size_t> ready(1, 0);
+    size_t remaining = num_cells;
+    bool stop = false, ok = true;
+    exception_ptr ex;
+
+    auto worker = [&](unsigned w) {
+      size_t next = num_cells;
+      for (;;) {
+        if (num_cells == next) {
+          unique_lock<mutex> lock(mtx);
+          cv.wait(lock, [&]() {
+            return stop || 0 == remaining || !ready.empty();
+          });
+          if (stop || 0 == remaining) {
+            return;
+          }
+          next = ready.back();
+          ready.pop_back();
+        }
+        size_t c = next, I = c / cols, J = c % cols;
+        next = num_cells;
+        bool carry_on;
+        try {
+          carry_on = f(w, I, J);
+        } catch (...) {
+          lock_guard<mutex> lock(mtx);
+          if (!ex) ex = current_exception();
+          stop = true;
+          cv.notify_all();
+          return;
+        }
+        if (!carry_on) {
+          lock_guard<mutex> lock(mtx);
+          ok = false;
+          stop = true;
+          cv.notify_all();
+          return;
+        }
+        auto release = [&](size_t s) {
+          return 1 == deps[s].fetch_sub(1, memory_order_acq_rel);
+        };
+        size_t succ[2], num_succ = 0;
+        if (J + 1 < cols && release(c + 1)) {
+          succ[num_succ++] = c + 1;
+        }
+        if (I + 1 < rows && release(c + cols)) {
+          succ[num_succ++] = c + cols;
+        }
+        {
+          lock_guard<mutex> lock(mtx);
+          // Another worker may have called a halt while we were at it
+          if (stop) {
+            return;
+          }
+          --remaining;
+          if (2 == num_succ) {
+            ready.push_back(succ[1]);
+            cv.notify_one();
+          } else if (0 == remaining) {
+            cv.notify_all();
+          }
+        }
+        if (num_succ) {
+          next = succ[0];
+        }
+      }
+    };
+
+    vector<thread> threads;
+    threads.reserve(num_threads - 1);
+    try {
+      for (unsigned w = 1; w < num_threads; ++w) {
+        threads.emplace_back(worker, w);
+      }
+    } catch (...) {
+      // Couldn't start every thread; those that did start (with our help)
+      // will take every cell from the queue, & see all the work through, so
+      // there's nothing to report.
+    }
+    worker(0);
+    for (auto &t: threads) {
+      t.join();
+    }
+
+    if (ex) {
+      rethrow_exception(ex);
+    }
+    return ok;
+  }
+
+} // namespace dl
+
+#endif // PARALLEL_HH_INCLUDED
@@ -0,0 +1,162 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "perf.hh"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(HAVE_LINUX_PERF_EVENT_H) && defined(HAVE_SYS_IOCTL_H) && \
+  defined(HAVE_SYS_SYSCALL_H) && defined(HAVE_UNISTD_H)
+# define HAVE_PERF_EVENTS 1
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace {
+
+# ifdef HAVE_PERF_EVENTS
+
+  /// The type & configuration of each event, in the order of
+  /// perf_counters::event
+  const struct {
+    std::uint32_t type;
+    std::uint64_t config;
+  } EVENTS[perf_counters::NUM_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+  };
+
+  /// Open a counter for the event described by \a type & \a config; return
+  /// its file descriptor, or -1 (with errno set)
+  int
+  open_counter(std::uint32_t type, std::uint64_t config)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    // Count the threads we're about to start, too...
+    attr.inherit = 1;
+    // but not the kernel, which an unprivileged process may not count.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                        PERF_FLAG_FD_CLOEXEC);
+  }
+
+# endif // HAVE_PERF_EVENTS
+
+}
+
+perf_counters::perf_counters()
+{
+  for (int e = 0; e < NUM_EVENTS; ++e) {
+    fd_[e] = -1;
+#   ifdef HAVE_PERF_EVENTS
+    fd_[e] = open_counter(EVENTS[e].type, EVENTS[e].config);
+    if (-1 == fd_[e]) {
+      why_[e] = std::string("perf_event_open: ") + std::strerror(errno);
+    }
+#   else
+    why_[e] = "not supported on this platform";
+#   endif
+  }
+}
+
+perf_counters::~perf_counters()
+{
+# ifdef HAVE_PERF_EVENTS
+  for (int e = 0; e < NUM_EVENTS; ++e) {
+    if (-1 != fd_[e]) {
+      close(fd_[e]);
+    }
+  }
+# endif
+}
+
+const char*
+perf_counters::name(event e)
+{
+  static const char * const NAMES[NUM_EVENTS] = {
+    "cycles",
+    "instructions",
+    "branch-misses",
+    "L1-dcache-load-misses",
+    "LLC-load-misses",
+    "task-clock",
+  };
+  return NAMES[e];
+}
+
+void
+perf_counters::start()
+{
+# ifdef HAVE_PERF_EVENTS
+  for (int e = 0; e < NUM_EVENTS; ++e) {
+    if (-1 != fd_[e]) {
+      ioctl(fd_[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+# endif
+}
+
+void
+perf_counters::stop()
+{
+# ifdef HAVE_PERF_EVENTS
+  for (int e = 0; e < NUM_EVENTS; ++e) {
+    if (-1 != fd_[e]) {
+      ioctl(fd_[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+# endif
+}
+
+std::uint64_t
+perf_counters::value(event e) const
+{
+# ifdef HAVE_PERF_EVENTS
+  // The count, the time for which the event was enabled & the time for which
+  // it was actually being counted
+  std::uint64_t buf[3];
+  if (-1 == fd_[e] ||
+      (ssize_t)sizeof(buf) != read(fd_[e], buf, sizeof(buf)) ||
+      0 == buf[2]) {
+    return 0;
+  }
+  if (buf[2] < buf[1]) {
+    return (std::uint64_t)((double)buf[0] * buf[1] / buf[2]);
+  }
+  return buf[0];
+# else
+  return 0;
+# endif
+}
@@ -0,0 +1,96 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef PERF_HH_INCLUDED
+#define PERF_HH_INCLUDED 1
+
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief The CPU's performance counters, as seen by this process
+ *
+ *
+ * Wall-clock time alone can't say why one algorithm is faster than another
+ * on a given corpus. The counters can: instructions per cycle, branch misses
+ * & cache misses tell whether an algorithm is doing too much work, guessing
+ * wrong at its branches, or waiting on memory.
+ *
+ * On Linux, each event is counted by perf_event_open(2), for this process &
+ * every thread it starts while the counters are open, in user space only
+ * (which is all an unprivileged process may count under the default
+ * perf_event_paranoid setting). Events are counted only between start & stop,
+ * & accumulate across successive intervals. If the kernel has more events
+ * than hardware counters to count them with, it takes turns, & the counts are
+ * scaled up to the time for which they were enabled.
+ *
+ * Counters that can't be opened (the platform isn't Linux, or the process
+ * lacks permission, or the CPU, or the virtual machine in which it's running,
+ * doesn't support the event) are simply unavailable; why_not says why. The
+ * task clock is a software event, & so is available wherever perf_event_open
+ * is.
+ *
+ *
+ */
+
+class perf_counters
+{
+public:
+  /// The events counted
+  enum event {
+    cycles,
+    instructions,
+    branch_misses,
+    /// Level one data cache misses on reads
+    l1d_misses,
+    /// Last-level cache misses on reads
+    llc_misses,
+    /// The time, in nanoseconds, for which the process was on a CPU
+    task_clock,
+  };
+  /// The number of events
+  static const int NUM_EVENTS = task_clock + 1;
+
+public:
+  /// Open the counters, but don't start them
+  perf_counters();
+  perf_counters(const perf_counters &) = delete;
+  ~perf_counters();
+  perf_counters& operator=(const perf_counters &) = delete;
+
+public:
+  /// Return the name of \a e (as perf(1) knows it)
+  static const char* name(event e);
+  /// Start (or resume) counting
+  void start();
+  /// Stop counting
+  void stop();
+  /// Return true if \a e is being counted
+  bool available(event e) const {
+    return -1 != fd_[e];
+  }
+  /// Return the reason \a e isn't being counted
+  const std::string& why_not(event e) const {
+    return why_[e];
+  }
+  /// Return the count of \a e so far, or zero if it's unavailable
+  std::uint64_t value(event e) const;
+
+private:
+  int fd_[NUM_EVENTS];
+  std::string why_[NUM_EVENTS];
+};
+
+#endif // PERF_HH_INCLUDED
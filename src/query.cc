@@ -0,0 +1,92 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "query.hh"
+#include "bp_kernels.hh"
+
+#include <limits>
+
+using dl::detail::BP_WORD;
+
+dl::search_stats&
+dl::search_stats::operator+=(const search_stats &that)
+{
+  queries += that.queries;
+  evaluations += that.evaluations;
+  entries += that.entries;
+  return *this;
+}
+
+dl::query::query(std::string_view Q):
+  Q_(Q),
+  nb_((Q.length() + BP_WORD - 1) / BP_WORD),
+  PEQ_(256*nb_, 0)
+{
+  for (std::size_t i = 0; i < Q_.length(); ++i) {
+    PEQ_[(unsigned char)Q_[i]*nb_ + i/BP_WORD] |= std::uint64_t(1) << (i % BP_WORD);
+  }
+}
+
+std::size_t
+dl::query::distance(std::string_view B) const
+{
+  return distance_within(B, std::numeric_limits<std::size_t>::max(),
+                         this_thread_workspace());
+}
+
+std::size_t
+dl::query::distance(std::string_view B,
+                    workspace &ws) const
+{
+  return distance_within(B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::query::distance_within(std::string_view B,
+                           std::size_t max_k) const
+{
+  return distance_within(B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::query::distance_within(std::string_view B,
+                           std::size_t max_k,
+                           workspace &ws) const
+{
+  using namespace std;
+
+  // Unlike dl::hyyro, the query is always the "pattern", whichever string is
+  // the shorter; the restricted distance is symmetric, so this only costs us
+  // blocks when the candidate is much shorter than the query.
+  size_t m = Q_.length(), n = B.length();
+  if ((m > n ? m - n : n - m) > max_k) {
+    return max_k + 1;
+  }
+  if (0 == m) {
+    return n;
+  }
+  if (0 == n) {
+    return m;
+  }
+
+  auto row = [](char c) { return (size_t)(unsigned char)c; };
+  if (1 == nb_) {
+    return detail::hyyro_1(PEQ_.data(), m, B, max_k, row);
+  } else {
+    return detail::hyyro_n(PEQ_.data(), m, B, max_k, row,
+                           ws.reserve<uint64_t>(4*nb_));
+  }
+}
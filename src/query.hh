@@ -0,0 +1,234 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef QUERY_HH_INCLUDED
+#define QUERY_HH_INCLUDED 1
+
+#include "workspace.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /// A candidate found to be within the threshold given to query::matches
+  /// (or to an index's search)
+  struct match {
+    /// The candidate's position in the range that was searched (or from which
+    /// the index was built)
+    std::size_t index;
+    /// The candidate's distance from the query
+    std::size_t distance;
+  };
+
+  /// What one or more searches of a dictionary index cost
+  struct search_stats {
+    /// The number of searches made
+    std::size_t queries = 0;
+    /// The work done in the course of those searches: the number of
+    /// distances computed (by a dl::bk_tree or dl::deletion_index) or of rows
+    /// of the recurrence computed (by a dl::trie)
+    std::size_t evaluations = 0;
+    /// The work a linear scan of the dictionary would have done for the same
+    /// searches, in the same units
+    std::size_t entries = 0;
+
+    search_stats& operator+=(const search_stats &that);
+  };
+
+  /**
+   * \brief A string to be compared against many others
+   *
+   *
+   * Comparing one string against thousands of candidates with dl::distance
+   * repeats the same per-string work on every call. A query does that work
+   * once: on construction, it builds the match vectors of Hyyrö's algorithm
+   * (for each character, a bit-vector marking the positions in the query at
+   * which it appears), which then serve for every candidate.
+   *
+   * Like dl::hyyro, a query computes the "restricted" Damerau-Levenshtein
+   * distance.
+   *
+   * A query is immutable once constructed & so may be shared between
+   * threads, each of which should supply its own workspace.
+   *
+   *
+   */
+
+  class query
+  {
+  public:
+    /// Pre-process \a Q for comparison against any number of candidates
+    explicit query(std::string_view Q);
+
+  public:
+    /// Return the query string
+    const std::string& str() const {
+      return Q_;
+    }
+
+    /**
+     * \brief Compute the Damerau-Levenshtein distance between the query & a
+     * candidate
+     *
+     *
+     * \param B [in] the candidate
+     *
+     * \return the Damerau-Levenshtein distance between the query & \a B
+     *
+     *
+     */
+
+    std::size_t
+    distance(std::string_view B) const;
+
+    /// Compute the Damerau-Levenshtein distance between the query & \a B in
+    /// the workspace \a ws
+    std::size_t
+    distance(std::string_view B,
+             workspace &ws) const;
+
+    /**
+     * \brief Compute the Damerau-Levenshtein distance between the query & a
+     * candidate, giving up once it is known to exceed a given threshold
+     *
+     *
+     * \param B [in] the candidate
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \return the Damerau-Levenshtein distance between the query & \a B if
+     * that is less than or equal to \a max_k, or \a max_k + 1 otherwise
+     *
+     *
+     */
+
+    std::size_t
+    distance_within(std::string_view B,
+                    std::size_t max_k) const;
+
+    /// Compute the Damerau-Levenshtein distance between the query & \a B, up
+    /// to \a max_k, in the workspace \a ws
+    std::size_t
+    distance_within(std::string_view B,
+                    std::size_t max_k,
+                    workspace &ws) const;
+
+    /**
+     * \brief Compute the Damerau-Levenshtein distance between the query & each
+     * of a range of candidates
+     *
+     *
+     * \param p0 [in] a forward input iterator referencing the beginning of a
+     * range of candidates (each dereferencing to something convertible to
+     * std::string_view)
+     *
+     * \param p1 [in] a forward input iterator referencing the one-past-the-end
+     * position of that range
+     *
+     * \param pout [in] a forward output iterator to which the distance to each
+     * candidate shall be written, in order
+     *
+     * \param ws [in,out] the workspace in which to carry-out each comparison
+     *
+     * \return \a pout, advanced past the last distance written
+     *
+     *
+     */
+
+    template <typename FII, typename FOI>
+    FOI
+    distances(FII p0,
+              FII p1,
+              FOI pout,
+              workspace &ws) const
+    {
+      for ( ; p0 != p1; ++p0) {
+        *pout++ = distance(*p0, ws);
+      }
+      return pout;
+    }
+
+    /// Write the distance between the query & each candidate in [\a p0,
+    /// \a p1), up to \a max_k, to \a pout
+    template <typename FII, typename FOI>
+    FOI
+    distances_within(FII p0,
+                     FII p1,
+                     std::size_t max_k,
+                     FOI pout,
+                     workspace &ws) const
+    {
+      for ( ; p0 != p1; ++p0) {
+        *pout++ = distance_within(*p0, max_k, ws);
+      }
+      return pout;
+    }
+
+    /**
+     * \brief Find those candidates in a range that are within a given
+     * distance of the query
+     *
+     *
+     * \param p0 [in] a forward input iterator referencing the beginning of a
+     * range of candidates
+     *
+     * \param p1 [in] a forward input iterator referencing the one-past-the-end
+     * position of that range
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \param pout [in] a forward output iterator to which a dl::match shall be
+     * written for each candidate no more than \a max_k from the query, in order
+     *
+     * \param ws [in,out] the workspace in which to carry-out each comparison
+     *
+     * \return \a pout, advanced past the last match written
+     *
+     *
+     */
+
+    template <typename FII, typename FOI>
+    FOI
+    matches(FII p0,
+            FII p1,
+            std::size_t max_k,
+            FOI pout,
+            workspace &ws) const
+    {
+      for (std::size_t i = 0; p0 != p1; ++p0, ++i) {
+        std::size_t d = distance_within(*p0, max_k, ws);
+        if (d <= max_k) {
+          *pout++ = match{i, d};
+        }
+      }
+      return pout;
+    }
+
+  private:
+    std::string Q_;
+    /// The number of 64-bit blocks needed to hold a bit-vector as long as the
+    /// query
+    std::size_t nb_;
+    /// PEQ_[c*nb_ + b] is block b of the match vector for character c
+    std::vector<std::uint64_t> PEQ_;
+  };
+
+} // namespace dl
+
+#endif // QUERY_HH_INCLUDED
@@ -0,0 +1,363 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "script.hh"
+#include "lw_tiles.hh"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace {
+
+  using dl::detail::TILE_COLS;
+  using dl::detail::tiling;
+
+  /// Sub-problems of no more than this many cells (or in which either string
+  /// is no longer than two characters) are solved with the full matrix
+  const std::size_t BASE_CELLS = 1 << 14;
+
+  /// What the divide step needs from a sweep over one half of the matrix
+  struct half {
+    /// The last two rows of the recurrence relation
+    std::vector<std::size_t> H0, H1;
+    /// For each column j, the last row i1 (save the last row of all) at
+    /// which A[i1-1] = B[j-1], & H(i1-1,j-2)
+    std::vector<std::size_t> i1, h;
+  };
+
+  /// Compute the recurrence relation between \a A & \a B (neither empty) a
+  /// tile at a time, as does dl::lowrance_wagner, & keep what's left of it
+  /// in \a out
+  template <typename CharT>
+  void
+  sweep(std::basic_string_view<CharT> A,
+        std::basic_string_view<CharT> B,
+        dl::workspace &ws,
+        half &out)
+  {
+    using namespace std;
+
+    size_t nA = A.length(), nB = B.length();
+    size_t nbuf = (3*(TILE_COLS + 2) + 7) / 8 * 8;
+    size_t *p = ws.reserve<size_t>(nbuf + tiling::words(nA, nB));
+    tiling t(nA, nB, p + nbuf);
+    for (size_t I = 0; I < t.num_rows; ++I) {
+      for (size_t J = 0; J < t.num_cols; ++J) {
+        dl::detail::tile(t, A, B, I, J, p, numeric_limits<size_t>::max());
+      }
+    }
+
+    // The tiles never touch column zero.
+    out.H0.assign(t.top0, t.top0 + nB + 1);
+    out.H1.assign(t.top1, t.top1 + nB + 1);
+    out.H0[0] = nA - 1;
+    out.H1[0] = nA;
+    out.i1.assign(t.col_i1, t.col_i1 + nB + 1);
+    out.h.assign(t.col_h, t.col_h + nB + 1);
+  }
+
+  /// Recover an edit script between two strings by divide & conquer (see
+  /// dl::edit_script)
+  template <typename CharT>
+  class scripter
+  {
+  public:
+    typedef std::basic_string_view<CharT> view_type;
+
+  public:
+    scripter(view_type A,
+             view_type B,
+             dl::workspace &ws,
+             std::vector<dl::edit> &out):
+      A_(A), B_(B),
+      rA_(A.rbegin(), A.rend()), rB_(B.rbegin(), B.rend()),
+      ws_(ws), out_(out)
+    { }
+
+  public:
+    /// Append an optimal script turning A[a0..a1) into B[b0..b1) to the
+    /// output
+    void solve(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1);
+
+  private:
+    /// As solve, with the full matrix
+    void solve_directly(std::size_t a0,
+                        std::size_t a1,
+                        std::size_t b0,
+                        std::size_t b1);
+    void emit(dl::edit_op op, std::size_t a, std::size_t b) {
+      out_.push_back(dl::edit{op, a, b});
+    }
+
+  private:
+    view_type A_, B_;
+    /// A_ & B_, reversed
+    std::basic_string<CharT> rA_, rB_;
+    dl::workspace &ws_;
+    std::vector<dl::edit> &out_;
+    /// The sweeps down to, & up to, the middle row of the current
+    /// sub-problem
+    half fwd_, bwd_;
+  };
+
+  template <typename CharT>
+  void
+  scripter<CharT>::solve(std::size_t a0,
+                         std::size_t a1,
+                         std::size_t b0,
+                         std::size_t b1)
+  {
+    using namespace std;
+
+    size_t m = a1 - a0, n = b1 - b0;
+    if (0 == m) {
+      for (size_t b = b0; b < b1; ++b) emit(dl::edit_op::insert, a0, b);
+      return;
+    }
+    if (0 == n) {
+      for (size_t a = a0; a < a1; ++a) emit(dl::edit_op::erase, a, b0);
+      return;
+    }
+    if (m <= 2 || n <= 2 || (m + 1)*(n + 1) <= BASE_CELLS) {
+      solve_directly(a0, a1, b0, b1);
+      return;
+    }
+
+    // Write F(i,j) for the distance between A[0..i) & B[0..j), & G(i,j) for
+    // that between A[i..m) & B[j..n) (all relative to this sub-problem). We
+    // get F over rows mid-1 & mid by sweeping the top half of the matrix, &
+    // G over rows mid+1 & mid by sweeping the bottom half, reversed: G(i,j)
+    // is the distance between the reversals of A[i..m) & B[j..n), which is
+    // R(m-i,n-j) below.
+    view_type A = A_.substr(a0, m), B = B_.substr(b0, n);
+    size_t mid = m / 2;
+    sweep(A.substr(0, mid), B, ws_, fwd_);
+    sweep(view_type(rA_).substr(A_.length() - a1, m - mid),
+          view_type(rB_).substr(B_.length() - b1, n), ws_, bwd_);
+    const vector<size_t> &F0 = fwd_.H0, &F1 = fwd_.H1;
+    const vector<size_t> &R0 = bwd_.H0, &R1 = bwd_.H1;
+
+    // An optimal path either passes through row mid at some column j, or
+    // jumps over it by a transposition. Per the argument in dl::detail::tiling,
+    // that can be assumed to be either a transposition of A[mid-1] & A[mid]
+    // with B[j1..j-2] inserted between them (`inserting'), or one of A[x] &
+    // A[y], x < mid <= y, with A[x+1..y-1] erased (`erasing') & taking them to
+    // B[j-1] & B[j-2]. In the latter case, x may be taken to be the last
+    // occurrence of B[j-1] before mid & y the first of B[j-2] at or after it,
+    // since the other candidates cost at least as much in erasures as they
+    // might save; the sweeps leave us exactly those.
+    const size_t INF = numeric_limits<size_t>::max();
+    enum { through, inserting, erasing } how = through;
+    size_t best = F1[0] + R1[n], bj = 0, bj1 = 0, bx = 0, by = 0;
+    for (size_t j = 1, j1 = 0; j <= n; ++j) {
+      size_t d = F1[j] + R1[n - j];
+      if (d < best) {
+        best = d; how = through; bj = j;
+      }
+      if (j >= 2) {
+        if (j1 && B[j-1] == A[mid-1]) {
+          d = F0[j1-1] + (j - j1) + R0[n - j];
+          if (d < best) {
+            best = d; how = inserting; bj = j; bj1 = j1;
+          }
+        }
+        size_t x = 0, y = 0, dx = INF, dy = INF, jr = n - j + 2;
+        if (A[mid-1] == B[j-1]) {
+          x = mid - 1;
+          dx = F0[j-2];
+        } else if (fwd_.i1[j]) {
+          x = fwd_.i1[j] - 1;
+          dx = fwd_.h[j] + (mid - 1 - x);
+        }
+        if (A[mid] == B[j-2]) {
+          y = mid;
+          dy = R0[n - j];
+        } else if (bwd_.i1[jr]) {
+          y = m - bwd_.i1[jr];
+          dy = bwd_.h[jr] + (y - mid);
+        }
+        if (INF != dx && INF != dy && dx + dy + 1 < best) {
+          best = dx + dy + 1; how = erasing; bj = j; bx = x; by = y;
+        }
+      }
+      if (B[j-1] == A[mid]) j1 = j;
+    }
+
+    // The sweeps' results are no longer needed, so the halves may re-use
+    // them.
+    if (through == how) {
+      solve(a0, a0 + mid, b0, b0 + bj);
+      solve(a0 + mid, a1, b0 + bj, b1);
+    } else if (inserting == how) {
+      solve(a0, a0 + mid - 1, b0, b0 + bj1 - 1);
+      emit(dl::edit_op::transpose, a0 + mid - 1, b0 + bj1 - 1);
+      for (size_t j = bj1; j < bj - 1; ++j) {
+        emit(dl::edit_op::insert, a0 + mid, b0 + j);
+      }
+      solve(a0 + mid + 1, a1, b0 + bj, b1);
+    } else {
+      solve(a0, a0 + bx, b0, b0 + bj - 2);
+      emit(dl::edit_op::transpose, a0 + bx, b0 + bj - 2);
+      for (size_t i = bx + 1; i < by; ++i) {
+        emit(dl::edit_op::erase, a0 + i, b0 + bj - 1);
+      }
+      solve(a0 + by + 1, a1, b0 + bj, b1);
+    }
+  }
+
+  template <typename CharT>
+  void
+  scripter<CharT>::solve_directly(std::size_t a0,
+                                  std::size_t a1,
+                                  std::size_t b0,
+                                  std::size_t b1)
+  {
+    using namespace std;
+
+    view_type A = A_.substr(a0, a1 - a0), B = B_.substr(b0, b1 - b0);
+    size_t m = A.length(), n = B.length(), W = n + 1;
+
+    // Fill-in the matrix, with the transposition term as in
+    // dl::detail::tile: `col[j]' is the last row i1 before this one at
+    // which A[i1-1] = B[j-1], & `j1' the last column before this one at
+    // which B[j1-1] = A[i-1]...
+    size_t *H = ws_.reserve<size_t>((m + 1)*W + W), *col = H + (m + 1)*W;
+    for (size_t j = 0; j <= n; ++j) {
+      H[j] = j;
+      col[j] = 0;
+    }
+    for (size_t i = 1; i <= m; ++i) {
+      size_t *Hi = H + i*W, *Hi1 = Hi - W;
+      Hi[0] = i;
+      for (size_t j = 1, j1 = 0; j <= n; ++j) {
+        size_t h;
+        if (A[i-1] == B[j-1]) {
+          h = Hi1[j-1];
+          j1 = j;
+          col[j] = i;
+        } else {
+          h = min(min(Hi1[j-1], Hi1[j]), Hi[j-1]) + 1;
+          if (i >= 2 && j1 && A[i-2] == B[j-1]) {
+            h = min(h, H[(i-2)*W + j1-1] + (j - j1));
+          }
+          if (j >= 2 && col[j] && B[j-2] == A[i-1]) {
+            h = min(h, H[(col[j]-1)*W + j-2] + (i - col[j]));
+          }
+        }
+        Hi[j] = h;
+      }
+    }
+
+    // & trace a path back from the bottom right-hand corner, writing the
+    // script backward.
+    size_t start = out_.size();
+    for (size_t i = m, j = n; i || j; ) {
+      size_t h = H[i*W + j];
+      if (i && j && h == H[(i-1)*W + j-1] + (A[i-1] == B[j-1] ? 0 : 1)) {
+        if (A[i-1] != B[j-1]) {
+          emit(dl::edit_op::substitute, a0 + i-1, b0 + j-1);
+        }
+        --i; --j;
+      } else if (i && h == H[(i-1)*W + j] + 1) {
+        emit(dl::edit_op::erase, a0 + i-1, b0 + j);
+        --i;
+      } else if (j && h == H[i*W + j-1] + 1) {
+        emit(dl::edit_op::insert, a0 + i, b0 + j-1);
+        --j;
+      } else {
+        size_t j1 = j - 1;
+        while (j1 && B[j1-1] != A[i-1]) --j1;
+        if (i >= 2 && A[i-2] == B[j-1] && j1 &&
+            h == H[(i-2)*W + j1-1] + (j - j1)) {
+          for (size_t k = j - 1; k > j1; --k) {
+            emit(dl::edit_op::insert, a0 + i-1, b0 + k-1);
+          }
+          emit(dl::edit_op::transpose, a0 + i-2, b0 + j1-1);
+          i -= 2;
+          j = j1 - 1;
+        } else {
+          size_t i1 = i - 1;
+          while (B[j-1] != A[i1-1]) --i1;
+          for (size_t k = i - 1; k > i1; --k) {
+            emit(dl::edit_op::erase, a0 + k-1, b0 + j-1);
+          }
+          emit(dl::edit_op::transpose, a0 + i1-1, b0 + j-2);
+          i = i1 - 1;
+          j -= 2;
+        }
+      }
+    }
+    reverse(out_.begin() + start, out_.end());
+  }
+
+  template <typename CharT>
+  std::vector<dl::edit>
+  edit_script(std::basic_string_view<CharT> A,
+              std::basic_string_view<CharT> B,
+              dl::workspace &ws)
+  {
+    std::vector<dl::edit> S;
+    scripter<CharT>(A, B, ws, S).solve(0, A.length(), 0, B.length());
+    return S;
+  }
+
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::string_view A,
+                std::string_view B)
+{
+  return ::edit_script(A, B, this_thread_workspace());
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::string_view A,
+                std::string_view B,
+                workspace &ws)
+{
+  return ::edit_script(A, B, ws);
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::u16string_view A,
+                std::u16string_view B)
+{
+  return ::edit_script(A, B, this_thread_workspace());
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::u16string_view A,
+                std::u16string_view B,
+                workspace &ws)
+{
+  return ::edit_script(A, B, ws);
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::u32string_view A,
+                std::u32string_view B)
+{
+  return ::edit_script(A, B, this_thread_workspace());
+}
+
+std::vector<dl::edit>
+dl::edit_script(std::u32string_view A,
+                std::u32string_view B,
+                workspace &ws)
+{
+  return ::edit_script(A, B, ws);
+}
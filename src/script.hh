@@ -0,0 +1,127 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef SCRIPT_HH_INCLUDED
+#define SCRIPT_HH_INCLUDED 1
+
+#include "workspace.hh"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /// The operations making up an edit script
+  enum class edit_op {
+    /// Insert B[b] ahead of A[a]
+    insert,
+    /// Delete A[a]
+    erase,
+    /// Replace A[a] with B[b]
+    substitute,
+    /// Swap A[a] with the next character of A that isn't erased (see
+    /// dl::edit_script)
+    transpose
+  };
+
+  /// One step of an edit script
+  struct edit {
+    edit_op op;
+    /// The position in the first string at which the edit is made
+    std::size_t a;
+    /// The corresponding position in the second string
+    std::size_t b;
+  };
+
+  /**
+   * \brief Recover an optimal sequence of edits turning one string into
+   * another
+   *
+   *
+   * \param A [in] the string to be edited
+   *
+   * \param B [in] the string into which it is to be edited
+   *
+   * \return a shortest sequence of edits turning \a A into \a B, in order
+   * of position; its length is the distance computed by dl::lowrance_wagner
+   *
+   *
+   * The characters of \a A & \a B not mentioned are left as they are. Each
+   * edit gives the position in \a A at which it is made & the position in
+   * \a B of its result: an insertion puts B[b] ahead of A[a], an erasure
+   * deletes A[a] (b being the position in \a B of whatever follows), & a
+   * substitution replaces A[a] with B[b].
+   *
+   * Lowrance & Wagner allow a transposition to swap two characters that are
+   * not adjacent in \a A, provided those between them are erased first, or
+   * to swap two that are adjacent & then insert characters between them. So
+   * a transposition at (a,b) is followed immediately by the erasures or
+   * insertions it entails (which are costed separately): A[a] & the next
+   * character of \a A not erased become the next character of \a B not
+   * inserted & B[b], respectively.
+   *
+   * Rather than keep the full matrix of the recurrence relation, this
+   * proceeds after Hirschberg (1975): the distances from the top of the
+   * matrix to its middle row are computed forward, & those from the bottom
+   * to the middle row computed backward (as the distances between the
+   * reversed strings), a tile at a time as in dl::lowrance_wagner; the point
+   * at which an optimal path crosses the middle row (or the transposition by
+   * which it jumps over it) splits the problem in two, & each half is solved
+   * in the same way. Transpositions make a path's jumps longer, but only by
+   * way of two cases, each of which needs a word per column to be carried
+   * out of each half, so that the space needed remains O(m+n). Every level
+   * of the recursion computes about half the cells of the level above, so
+   * the whole costs about twice the distance alone.
+   *
+   *
+   */
+
+  std::vector<edit>
+  edit_script(std::string_view A,
+              std::string_view B);
+
+  /// Recover an optimal edit script turning \a A into \a B in the workspace
+  /// \a ws
+  std::vector<edit>
+  edit_script(std::string_view A,
+              std::string_view B,
+              workspace &ws);
+
+  /// As above, for strings of 16-bit characters
+  std::vector<edit>
+  edit_script(std::u16string_view A,
+              std::u16string_view B);
+
+  /// As above, for strings of 16-bit characters, in the workspace \a ws
+  std::vector<edit>
+  edit_script(std::u16string_view A,
+              std::u16string_view B,
+              workspace &ws);
+
+  /// As above, for strings of 32-bit characters
+  std::vector<edit>
+  edit_script(std::u32string_view A,
+              std::u32string_view B);
+
+  /// As above, for strings of 32-bit characters, in the workspace \a ws
+  std::vector<edit>
+  edit_script(std::u32string_view A,
+              std::u32string_view B,
+              workspace &ws);
+
+} // namespace dl
+
+#endif // SCRIPT_HH_INCLUDED
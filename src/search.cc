@@ -0,0 +1,458 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "search.hh"
+#include "corpus.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace {
+
+  typedef std::chrono::steady_clock clock_type;
+
+  long
+  msecs_since(clock_type::time_point then)
+  {
+    using namespace std::chrono;
+    return (long) duration_cast<milliseconds>(clock_type::now() - then).count();
+  }
+
+  /// Search \a index for each query in \a paths, converting each with
+  /// \a decode; \a name(i) yields the i-th dictionary word as it's to be
+  /// written to \a out
+  template <typename Index, typename Decode, typename Name>
+  void
+  search(const Index &index,
+         Decode decode,
+         Name name,
+         std::size_t max_k,
+         const std::vector<std::string> &paths,
+         std::ostream &out,
+         dl::search_stats &stats)
+  {
+    using namespace std;
+
+    dl::workspace ws;
+    vector<dl::match> M;
+    string line;
+    for (const string &pth: paths) {
+      ifstream ifs;
+      istream *is = &cin;
+      if ("-" != pth) {
+        ifs.open(pth);
+        if (!ifs) {
+          throw system_error(errno, generic_category(),
+                             "failed to open `" + pth + "'");
+        }
+        is = &ifs;
+      }
+      while (getline(*is, line)) {
+        if (line.empty() || '#' == line[0]) continue;
+        M.clear();
+        index.range_query(decode(line), max_k, back_inserter(M), ws, &stats);
+        sort(M.begin(), M.end(), [](const dl::match &a, const dl::match &b) {
+          return a.distance < b.distance ||
+            (a.distance == b.distance && a.index < b.index);
+        });
+        for (const dl::match &m: M) {
+          out << line << '\t' << name(m.index) << '\t' << m.distance << '\n';
+        }
+      }
+    }
+  }
+
+  /// Search \a index for each query in \a paths, decoding the queries from
+  /// UTF-8 if the index is over code points; \a name is as for search
+  template <typename Index, typename Name>
+  void
+  search(const Index &index,
+         Name name,
+         std::size_t max_k,
+         const std::vector<std::string> &paths,
+         std::ostream &out,
+         dl::search_stats &stats)
+  {
+    using namespace std;
+
+    if constexpr (is_same_v<typename Index::view_type, u32string_view>) {
+      u32string buf;
+      search(index, [&buf](const string &s) {
+        dl::utf8_decode(s, buf);
+        return u32string_view(buf);
+      }, name, max_k, paths, out, stats);
+    } else {
+      search(index, [](const string &s) {
+        return string_view(s);
+      }, name, max_k, paths, out, stats);
+    }
+  }
+
+  /// Build an index of type \a Index over [\a p0, \a p1); only some types
+  /// of index need know the largest distance for which they'll be searched,
+  /// or can make use of more than one thread
+  template <typename Index, typename FII>
+  Index
+  build(FII p0, FII p1, std::size_t max_k, unsigned num_threads)
+  {
+    if constexpr (std::is_constructible_v<Index, FII, FII, std::size_t,
+                                          unsigned>) {
+      return Index(p0, p1, max_k, num_threads);
+    } else {
+      return Index(p0, p1);
+    }
+  }
+
+  /// Index \a W (as read) in an index of type \a Index, first decoding the
+  /// words from UTF-8 if the index is over code points
+  template <typename Index>
+  Index
+  index_words(const std::vector<std::string_view> &W,
+              std::size_t max_k,
+              unsigned num_threads)
+  {
+    using namespace std;
+
+    if constexpr (is_same_v<typename Index::view_type, u32string_view>) {
+      vector<u32string> U;
+      U.reserve(W.size());
+      for (string_view w: W) {
+        U.push_back(dl::utf8_decode(w));
+      }
+      return build<Index>(U.begin(), U.end(), max_k, num_threads);
+    } else {
+      return build<Index>(W.begin(), W.end(), max_k, num_threads);
+    }
+  }
+
+  /// Index \a W in an index of type \a Index & search it for each query in
+  /// \a paths; returns the time taken to build the index, in milliseconds
+  template <typename Index>
+  long
+  index_and_search(const std::vector<std::string_view> &W,
+                   std::size_t max_k,
+                   unsigned num_threads,
+                   const std::vector<std::string> &paths,
+                   std::ostream &out,
+                   dl::search_stats &stats)
+  {
+    auto then = clock_type::now();
+    Index index = index_words<Index>(W, max_k, num_threads);
+    long index_ms = msecs_since(then);
+    search(index, [&W](std::size_t i) {
+      return W[i];
+    }, max_k, paths, out, stats);
+    return index_ms;
+  }
+
+  /// Index \a W in an index of type \a Index & save it to \a pth; returns
+  /// the time taken to build the index, in milliseconds
+  template <typename Index>
+  long
+  index_and_save(const std::vector<std::string_view> &W,
+                 std::size_t max_k,
+                 unsigned num_threads,
+                 const std::string &pth)
+  {
+    auto then = clock_type::now();
+    Index index = index_words<Index>(W, max_k, num_threads);
+    long index_ms = msecs_since(then);
+    index.save(pth);
+    return index_ms;
+  }
+
+  /// Load an index of type \a Index from \a f & search it for each query in
+  /// \a paths
+  template <typename Index>
+  void
+  load_and_search(const dl::index_file &f,
+                  std::size_t max_k,
+                  const std::vector<std::string> &paths,
+                  std::ostream &out,
+                  dl::search_stats &stats)
+  {
+    using namespace std;
+
+    Index index(f);
+    if constexpr (is_same_v<typename Index::view_type, u32string_view>) {
+      string buf;
+      search(index, [&index, &buf](size_t i) {
+        buf.clear();
+        dl::utf8_encode(index.word(i), buf);
+        return string_view(buf);
+      }, max_k, paths, out, stats);
+    } else {
+      search(index, [&index](size_t i) {
+        return index.word(i);
+      }, max_k, paths, out, stats);
+    }
+  }
+
+  /// A linear scan of a dictionary for the words nearest each query (see
+  /// dl::nearest), posing as an index so that it may be handed to search
+  template <typename CharT>
+  class nearest_scan
+  {
+  public:
+    typedef std::basic_string_view<CharT> view_type;
+
+  public:
+    nearest_scan(std::vector<view_type> &&C,
+                 std::size_t n,
+                 unsigned num_threads):
+      C_(std::move(C)), n_(n), num_threads_(num_threads)
+    { }
+
+  public:
+    template <typename FOI>
+    FOI
+    range_query(view_type q,
+                std::size_t max_k,
+                FOI pout,
+                dl::workspace &,
+                dl::search_stats *stats) const
+    {
+      std::vector<dl::match> M = dl::nearest(q, C_, n_, max_k, num_threads_,
+                                             true, stats);
+      return std::copy(M.begin(), M.end(), pout);
+    }
+
+  private:
+    std::vector<view_type> C_;
+    std::size_t n_;
+    unsigned num_threads_;
+  };
+
+  /// Write \a stats, gathered while searching an index of type \a index, to
+  /// stderr
+  void
+  print_stats(dictionary_index index, const dl::search_stats &stats)
+  {
+    using namespace std;
+
+    const char *units = dictionary_index::trie == index ?
+      " rows of the recurrence" : " comparisons";
+    cerr << stats.queries << " queries computed " << stats.evaluations <<
+      units << " (a linear scan would have computed " << stats.entries <<
+      ")" << endl;
+  }
+
+}
+
+void
+search_dictionary(const std::string &dict,
+                  dictionary_index index,
+                  std::size_t max_k,
+                  bool utf8,
+                  unsigned num_threads,
+                  bool print_timings,
+                  const std::vector<std::string> &paths,
+                  std::ostream &out)
+{
+  using namespace std;
+
+  corpus_file f(dict);
+  vector<string_view> W;
+  read_words(f, back_inserter(W));
+
+  dl::search_stats stats;
+  auto then = clock_type::now();
+  long index_ms;
+  switch (index) {
+  case dictionary_index::trie:
+    index_ms = utf8 ?
+      index_and_search<dl::u32trie>(W, max_k, num_threads, paths, out, stats) :
+      index_and_search<dl::trie>(W, max_k, num_threads, paths, out, stats);
+    break;
+  case dictionary_index::deletion:
+    index_ms = utf8 ?
+      index_and_search<dl::u32deletion_index>(W, max_k, num_threads, paths,
+                                              out, stats) :
+      index_and_search<dl::deletion_index>(W, max_k, num_threads, paths, out,
+                                           stats);
+    break;
+  default:
+    index_ms = utf8 ?
+      index_and_search<dl::u32bk_tree>(W, max_k, num_threads, paths, out,
+                                       stats) :
+      index_and_search<dl::bk_tree>(W, max_k, num_threads, paths, out, stats);
+    break;
+  }
+  long search_ms = msecs_since(then) - index_ms;
+  out.flush();
+
+  if (print_timings) {
+    cerr << "indexing " << W.size() << " words took " << index_ms << "ms" <<
+      endl;
+    cerr << "processing took " << search_ms << "ms" << endl;
+    print_stats(index, stats);
+  }
+}
+
+void
+build_index(const std::string &dict,
+            dictionary_index index,
+            std::size_t max_k,
+            bool utf8,
+            unsigned num_threads,
+            bool print_timings,
+            const std::string &pth)
+{
+  using namespace std;
+
+  corpus_file f(dict);
+  vector<string_view> W;
+  read_words(f, back_inserter(W));
+
+  auto then = clock_type::now();
+  long index_ms;
+  switch (index) {
+  case dictionary_index::trie:
+    index_ms = utf8 ?
+      index_and_save<dl::u32trie>(W, max_k, num_threads, pth) :
+      index_and_save<dl::trie>(W, max_k, num_threads, pth);
+    break;
+  case dictionary_index::deletion:
+    index_ms = utf8 ?
+      index_and_save<dl::u32deletion_index>(W, max_k, num_threads, pth) :
+      index_and_save<dl::deletion_index>(W, max_k, num_threads, pth);
+    break;
+  default:
+    index_ms = utf8 ?
+      index_and_save<dl::u32bk_tree>(W, max_k, num_threads, pth) :
+      index_and_save<dl::bk_tree>(W, max_k, num_threads, pth);
+    break;
+  }
+  long save_ms = msecs_since(then) - index_ms;
+
+  if (print_timings) {
+    cerr << "indexing " << W.size() << " words took " << index_ms << "ms" <<
+      endl;
+    cerr << "saving the index took " << save_ms << "ms" << endl;
+  }
+}
+
+void
+query_index(const std::string &pth,
+            std::size_t max_k,
+            bool verify,
+            bool print_timings,
+            const std::vector<std::string> &paths,
+            std::ostream &out)
+{
+  using namespace std;
+
+  auto then = clock_type::now();
+  dl::index_file f(pth, verify);
+  long load_ms = msecs_since(then);
+  if (1 != f.char_size() && 4 != f.char_size()) {
+    throw runtime_error("`" + pth + "' holds an index over " +
+                        to_string(f.char_size()) + "-byte characters, which "
+                        "this program can't search");
+  }
+  bool utf8 = 4 == f.char_size();
+
+  dl::search_stats stats;
+  dictionary_index index;
+  then = clock_type::now();
+  switch (f.kind()) {
+  case dl::index_kind::trie:
+    index = dictionary_index::trie;
+    if (utf8) {
+      load_and_search<dl::u32trie>(f, max_k, paths, out, stats);
+    } else {
+      load_and_search<dl::trie>(f, max_k, paths, out, stats);
+    }
+    break;
+  case dl::index_kind::deletion:
+    index = dictionary_index::deletion;
+    if (utf8) {
+      load_and_search<dl::u32deletion_index>(f, max_k, paths, out, stats);
+    } else {
+      load_and_search<dl::deletion_index>(f, max_k, paths, out, stats);
+    }
+    break;
+  case dl::index_kind::bk_tree:
+    index = dictionary_index::bk_tree;
+    if (utf8) {
+      load_and_search<dl::u32bk_tree>(f, max_k, paths, out, stats);
+    } else {
+      load_and_search<dl::bk_tree>(f, max_k, paths, out, stats);
+    }
+    break;
+  default:
+    throw runtime_error("`" + pth + "' holds an unknown kind of index");
+  }
+  long search_ms = msecs_since(then);
+  out.flush();
+
+  if (print_timings) {
+    cerr << "loading the index took " << load_ms << "ms" << endl;
+    cerr << "processing took " << search_ms << "ms" << endl;
+    print_stats(index, stats);
+  }
+}
+
+void
+nearest_in_dictionary(const std::string &dict,
+                      std::size_t n,
+                      std::size_t max_k,
+                      bool utf8,
+                      unsigned num_threads,
+                      bool print_timings,
+                      const std::vector<std::string> &paths,
+                      std::ostream &out)
+{
+  using namespace std;
+
+  corpus_file f(dict);
+  vector<string_view> W;
+  read_words(f, back_inserter(W));
+  auto name = [&W](size_t i) {
+    return W[i];
+  };
+
+  dl::search_stats stats;
+  auto then = clock_type::now();
+  if (utf8) {
+    vector<u32string> U;
+    vector<u32string_view> C;
+    U.reserve(W.size());
+    for (string_view w: W) {
+      U.push_back(dl::utf8_decode(w));
+      C.push_back(U.back());
+    }
+    search(nearest_scan<char32_t>(move(C), n, num_threads), name, max_k, paths,
+           out, stats);
+  } else {
+    search(nearest_scan<char>(vector<string_view>(W), n, num_threads), name,
+           max_k, paths, out, stats);
+  }
+  long search_ms = msecs_since(then);
+  out.flush();
+
+  if (print_timings) {
+    cerr << "processing took " << search_ms << "ms" << endl;
+    cerr << stats.queries << " queries computed " << stats.evaluations <<
+      " comparisons (of " << stats.entries << " candidates)" << endl;
+  }
+}
@@ -0,0 +1,201 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef SEARCH_HH_INCLUDED
+#define SEARCH_HH_INCLUDED 1
+
+#include "damlev.hh"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// The index in which search_dictionary shall hold the dictionary
+enum class dictionary_index {
+  /// dl::bk_tree
+  bk_tree,
+  /// dl::trie
+  trie,
+  /// dl::deletion_index
+  deletion,
+};
+
+/**
+ * \brief Look up each of a stream of queries in a dictionary
+ *
+ *
+ * \param dict [in] The path of a file containing the dictionary, one word per
+ * line (see read_words)
+ *
+ * \param index [in] The index in which to hold the dictionary
+ *
+ * \param max_k [in] The largest distance of interest
+ *
+ * \param utf8 [in] If true, decode the dictionary & the queries from UTF-8 &
+ * compare code points rather than bytes
+ *
+ * \param num_threads [in] The number of threads on which to build the index
+ * (only a dl::deletion_index makes use of more than one)
+ *
+ * \param print_timings [in] If true, write the time spent indexing the
+ * dictionary & searching it, along with the work done (see dl::search_stats),
+ * to stderr
+ *
+ * \param paths [in] The files from which queries shall be read, one per line;
+ * "-" names standard input
+ *
+ * \param out [in] The stream to which matches shall be written
+ *
+ *
+ * The dictionary is indexed in a dl::bk_tree, a dl::trie or a
+ * dl::deletion_index, which is then searched for each query. For each word
+ * within \a max_k of a query, a line of three tab-delimited fields is written
+ * to \a out: the query, the word & the distance between them. The distance is
+ * the unrestricted one (see dl::bk_tree), unless \a index is
+ * dictionary_index::deletion, in which case it's the restricted one. The
+ * matches for each query are written closest first, & in dictionary order
+ * among those equally distant.
+ *
+ *
+ */
+
+void
+search_dictionary(const std::string &dict,
+                  dictionary_index index,
+                  std::size_t max_k,
+                  bool utf8,
+                  unsigned num_threads,
+                  bool print_timings,
+                  const std::vector<std::string> &paths,
+                  std::ostream &out);
+
+/**
+ * \brief Look up the words in a dictionary nearest each of a stream of
+ * queries
+ *
+ *
+ * \param dict [in] The path of a file containing the dictionary, one word per
+ * line (see read_words)
+ *
+ * \param n [in] The number of words wanted for each query
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param utf8 [in] If true, decode the dictionary & the queries from UTF-8 &
+ * compare code points rather than bytes
+ *
+ * \param num_threads [in] The number of threads over which to spread the
+ * dictionary for each query
+ *
+ * \param print_timings [in] If true, write the time spent searching, along
+ * with the number of comparisons made, to stderr
+ *
+ * \param paths [in] The files from which queries shall be read, one per line;
+ * "-" names standard input
+ *
+ * \param out [in] The stream to which matches shall be written
+ *
+ *
+ * The dictionary is scanned with dl::nearest for each query. The output is
+ * as for search_dictionary, but with the \a n nearest words for each query
+ * (the distances being restricted ones).
+ *
+ *
+ */
+
+void
+nearest_in_dictionary(const std::string &dict,
+                      std::size_t n,
+                      std::size_t max_k,
+                      bool utf8,
+                      unsigned num_threads,
+                      bool print_timings,
+                      const std::vector<std::string> &paths,
+                      std::ostream &out);
+
+/**
+ * \brief Index a dictionary & save the index to disk
+ *
+ *
+ * \param dict [in] The path of a file containing the dictionary, one word per
+ * line (see read_words)
+ *
+ * \param index [in] The sort of index to build
+ *
+ * \param max_k [in] The largest distance for which the index will be searched
+ * (only a dl::deletion_index needs to know)
+ *
+ * \param utf8 [in] If true, decode the dictionary from UTF-8 & index code
+ * points rather than bytes
+ *
+ * \param num_threads [in] The number of threads on which to build the index
+ *
+ * \param print_timings [in] If true, write the time spent indexing the
+ * dictionary & saving the index to stderr
+ *
+ * \param pth [in] The path to which the index shall be written (see
+ * dl::index_file)
+ *
+ *
+ */
+
+void
+build_index(const std::string &dict,
+            dictionary_index index,
+            std::size_t max_k,
+            bool utf8,
+            unsigned num_threads,
+            bool print_timings,
+            const std::string &pth);
+
+/**
+ * \brief Look up each of a stream of queries in an index saved by build_index
+ *
+ *
+ * \param pth [in] The path of the index
+ *
+ * \param max_k [in] The largest distance of interest
+ *
+ * \param verify [in] If true, check the index file's checksum before
+ * searching it
+ *
+ * \param print_timings [in] If true, write the time spent loading the index &
+ * searching it, along with the work done, to stderr
+ *
+ * \param paths [in] The files from which queries shall be read, one per line;
+ * "-" names standard input
+ *
+ * \param out [in] The stream to which matches shall be written
+ *
+ *
+ * The sort of index, & whether its words are bytes or code points, are read
+ * from the file (in the latter case, the queries are decoded from UTF-8).
+ * The output is that of search_dictionary given the same dictionary & index,
+ * except that words that were ill-formed UTF-8 are written as re-encoded
+ * (with U+FFFD in place of each ill-formed sequence).
+ *
+ *
+ */
+
+void
+query_index(const std::string &pth,
+            std::size_t max_k,
+            bool verify,
+            bool print_timings,
+            const std::vector<std::string> &paths,
+            std::ostream &out);
+
+#endif // SEARCH_HH_INCLUDED
@@ -0,0 +1,347 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "stream.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+  /// Input is handed from the reader to the workers in chunks of about this
+  /// many bytes (rounded to whole lines)
+  const std::size_t CHUNK_BYTES = 1 << 16;
+
+  /// A chunk of input, along with the results computed from it
+  struct chunk {
+    /// Sequence number; results are written in this order
+    std::size_t seq;
+    /// The file from which this chunk was read, & the line number (in that
+    /// file) of its first line
+    std::string path;
+    std::size_t lineno;
+    /// One or more whole lines of input
+    std::string text;
+    /// The results, formatted for output
+    std::string out;
+    /// False if any pair was found to be other than its known distance
+    bool ok;
+    /// Non-empty if a line couldn't be parsed (in which case `out' holds the
+    /// results for the lines preceding it)
+    std::string error;
+  };
+
+  /// State shared between the reader, the workers & the writer
+  struct pipeline {
+    std::mutex mtx;
+    /// Signalled when there is room for another chunk in flight
+    std::condition_variable room;
+    /// Signalled when a chunk is available to the workers
+    std::condition_variable have_work;
+    /// Signalled when a chunk's results are available to the writer
+    std::condition_variable have_output;
+    std::deque<std::unique_ptr<chunk>> work;
+    std::map<std::size_t, std::unique_ptr<chunk>> done;
+    /// The number of chunks read but not yet written
+    std::size_t in_flight = 0;
+    /// True until the reader has reached the end of its input...
+    bool reading = true;
+    /// at which point, this is the total number of chunks read
+    std::size_t num_chunks = 0;
+    /// Set to bring the pipeline to a halt
+    bool stop = false;
+    /// The first exception thrown on any thread
+    std::exception_ptr error;
+
+    void
+    fail(std::exception_ptr ex)
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      if (!error) error = ex;
+      stop = true;
+      room.notify_all();
+      have_work.notify_all();
+      have_output.notify_all();
+    }
+  };
+
+  std::string
+  parse_error(const chunk &c,
+              std::size_t lineno)
+  {
+    std::stringstream stm;
+    stm << "parse error in `" << c.path << "', line " << lineno;
+    return stm.str();
+  }
+
+  /// Compute the distance for each pair in \a c (between the code points
+  /// they encode, if \a utf8 is true)
+  void
+  process(chunk &c,
+          dl::algorithm algo,
+          std::size_t max_k,
+          bool utf8,
+          dl::workspace &ws)
+  {
+    using namespace std;
+
+    const size_t NO_MAX_K = numeric_limits<size_t>::max();
+
+    u32string A32, B32;
+
+    c.ok = true;
+    string_view text(c.text);
+    size_t lineno = c.lineno;
+    for (size_t pos = 0; pos < text.size(); ++lineno) {
+      size_t eol = text.find('\n', pos);
+      if (string_view::npos == eol) eol = text.size();
+      string_view line = text.substr(pos, eol - pos);
+      pos = eol + 1;
+
+      if (line.empty() || line[0] == '#') continue;
+      string_view::size_type idx0 = line.find('\t');
+      if (string_view::npos == idx0) {
+        c.error = parse_error(c, lineno);
+        return;
+      }
+      string_view::size_type idx1 = line.find('\t', idx0 + 1);
+      string_view A = line.substr(0, idx0);
+      string_view B = line.substr(idx0 + 1, string_view::npos == idx1 ?
+                                  string_view::npos : idx1 - idx0 - 1);
+
+      bool known = string_view::npos != idx1;
+      size_t D = 0;
+      if (known) {
+        const char *p = line.data() + idx1 + 1, *pend = line.data() + line.size();
+        while (p < pend && (' ' == *p || '\t' == *p)) ++p;
+        if (from_chars(p, pend, D).ec != errc()) {
+          c.error = parse_error(c, lineno);
+          return;
+        }
+      }
+
+      size_t d;
+      if (utf8) {
+        dl::utf8_decode(A, A32);
+        dl::utf8_decode(B, B32);
+        d = NO_MAX_K == max_k ?
+          dl::distance(u32string_view(A32), u32string_view(B32), algo, ws) :
+          dl::distance_within(u32string_view(A32), u32string_view(B32), max_k,
+                              algo, ws);
+      } else {
+        d = NO_MAX_K == max_k ?
+          dl::distance(A, B, algo, ws) :
+          dl::distance_within(A, B, max_k, algo, ws);
+      }
+
+      c.out.append(A).append(1, '\t').append(B).append(1, '\t');
+      c.out.append(to_string(d));
+      if (known) {
+        size_t expected = D > max_k ? max_k + 1 : D;
+        if (d != expected) {
+          c.out.append("\tmismatch (expected ").append(to_string(expected));
+          c.out.append(1, ')');
+          c.ok = false;
+        }
+      }
+      c.out.append(1, '\n');
+    }
+  }
+
+  /// Read each of \a paths in turn, breaking them up into chunks
+  void
+  read_chunks(pipeline &pl,
+              const std::vector<std::string> &paths,
+              std::size_t max_in_flight)
+  {
+    using namespace std;
+
+    size_t seq = 0;
+    try {
+      for (const string &pth: paths) {
+        FILE *fp = "-" == pth ? stdin : fopen(pth.c_str(), "r");
+        if (!fp) {
+          throw system_error(errno, generic_category(),
+                             "failed to open `" + pth + "'");
+        }
+        unique_ptr<FILE, int (*)(FILE*)> guard(fp, stdin == fp ?
+                                               [](FILE*) { return 0; } :
+                                               fclose);
+        string carry;
+        size_t lineno = 1;
+        for (bool eof = false; !eof; ) {
+          auto c = make_unique<chunk>();
+          c->text = move(carry);
+          carry.clear();
+          size_t n0 = c->text.size();
+          c->text.resize(n0 + CHUNK_BYTES);
+          size_t nread = fread(&c->text[n0], 1, CHUNK_BYTES, fp);
+          c->text.resize(n0 + nread);
+          if (nread < CHUNK_BYTES) {
+            if (ferror(fp)) {
+              throw system_error(errno, generic_category(),
+                                 "failed to read `" + pth + "'");
+            }
+            eof = true;
+          } else {
+            // Hold back any partial line at the end of the chunk (if there's
+            // no newline at all, keep reading until there is)
+            size_t last = c->text.rfind('\n');
+            if (string::npos == last) {
+              carry = move(c->text);
+              continue;
+            }
+            carry.assign(c->text, last + 1, string::npos);
+            c->text.resize(last + 1);
+          }
+          if (c->text.empty()) continue;
+
+          c->seq = seq++;
+          c->path = pth;
+          c->lineno = lineno;
+          lineno += count(c->text.begin(), c->text.end(), '\n');
+
+          unique_lock<mutex> lk(pl.mtx);
+          pl.room.wait(lk, [&]() {
+            return pl.stop || pl.in_flight < max_in_flight;
+          });
+          if (pl.stop) return;
+          ++pl.in_flight;
+          pl.work.push_back(move(c));
+          pl.have_work.notify_one();
+        }
+      }
+    } catch (...) {
+      pl.fail(current_exception());
+      return;
+    }
+
+    lock_guard<mutex> lk(pl.mtx);
+    pl.reading = false;
+    pl.num_chunks = seq;
+    pl.have_work.notify_all();
+    pl.have_output.notify_all();
+  }
+
+  void
+  work(pipeline &pl,
+       dl::algorithm algo,
+       std::size_t max_k,
+       bool utf8)
+  {
+    using namespace std;
+
+    dl::workspace ws;
+    try {
+      for (;;) {
+        unique_ptr<chunk> c;
+        {
+          unique_lock<mutex> lk(pl.mtx);
+          pl.have_work.wait(lk, [&]() {
+            return pl.stop || !pl.work.empty() || !pl.reading;
+          });
+          if (pl.stop || pl.work.empty()) return;
+          c = move(pl.work.front());
+          pl.work.pop_front();
+        }
+        process(*c, algo, max_k, utf8, ws);
+        lock_guard<mutex> lk(pl.mtx);
+        size_t seq = c->seq;
+        pl.done.emplace(seq, move(c));
+        pl.have_output.notify_one();
+      }
+    } catch (...) {
+      pl.fail(current_exception());
+    }
+  }
+
+}
+
+bool
+stream_corpus(dl::algorithm algo,
+              std::size_t max_k,
+              bool utf8,
+              unsigned num_threads,
+              const std::vector<std::string> &paths,
+              std::ostream &out)
+{
+  using namespace std;
+
+  if (0 == num_threads) num_threads = 1;
+  // Enough to keep every worker busy while the writer catches up
+  size_t max_in_flight = 4 * num_threads;
+
+  pipeline pl;
+  vector<thread> threads;
+  threads.emplace_back(read_chunks, ref(pl), cref(paths), max_in_flight);
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads.emplace_back(work, ref(pl), algo, max_k, utf8);
+  }
+
+  bool ok = true;
+  try {
+    for (size_t next = 0; ; ++next) {
+      unique_ptr<chunk> c;
+      {
+        unique_lock<mutex> lk(pl.mtx);
+        pl.have_output.wait(lk, [&]() {
+          return pl.stop || pl.done.count(next) ||
+            (!pl.reading && next == pl.num_chunks);
+        });
+        if (pl.stop) break;
+        auto p = pl.done.find(next);
+        if (pl.done.end() == p) break;
+        c = move(p->second);
+        pl.done.erase(p);
+        --pl.in_flight;
+        pl.room.notify_one();
+      }
+      out.write(c->out.data(), c->out.size());
+      out.flush();
+      if (!c->ok) ok = false;
+      if (!c->error.empty()) {
+        pl.fail(make_exception_ptr(runtime_error(c->error)));
+        break;
+      }
+    }
+  } catch (...) {
+    pl.fail(current_exception());
+  }
+
+  for (auto &t: threads) {
+    t.join();
+  }
+  if (pl.error) {
+    rethrow_exception(pl.error);
+  }
+
+  return ok;
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef STREAM_HH_INCLUDED
+#define STREAM_HH_INCLUDED 1
+
+#include "damlev.hh"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Compute Damerau-Levenshtein distance over a stream of string pairs,
+ * writing each result as soon as it's known
+ *
+ *
+ * \param algo [in] The algorithm to be exercised
+ *
+ * \param max_k [in] The largest distance of interest (NO_MAX_K for no limit)
+ *
+ * \param utf8 [in] If true, decode each string from UTF-8 & compare code
+ * points rather than bytes
+ *
+ * \param num_threads [in] The number of worker threads over which to spread
+ * the computation
+ *
+ * \param paths [in] The files from which pairs shall be read, in order; "-"
+ * names standard input
+ *
+ * \param out [in] The stream to which results shall be written
+ *
+ * \return true if every pair bearing a known distance was found to be that
+ * distance apart, false else
+ *
+ *
+ * Input is in the same format as that read by read_corpus, save that the
+ * third field (the known distance) is optional. Each pair is written to
+ * \a out in the same format, with the third field being the computed
+ * distance; if that differs from the known distance, a fourth field noting
+ * the discrepancy is added.
+ *
+ * Rather than load the entire corpus before computing anything, a reader
+ * thread reads the input in chunks of about 64K, which are handed to a pool
+ * of workers; the writer (the calling thread) writes the results for each
+ * chunk in order, as soon as they're ready. The number of chunks in flight at
+ * any one time is bounded, so memory consumption is constant regardless of
+ * the size of the input.
+ *
+ *
+ */
+
+bool
+stream_corpus(dl::algorithm algo,
+              std::size_t max_k,
+              bool utf8,
+              unsigned num_threads,
+              const std::vector<std::string> &paths,
+              std::ostream &out);
+
+#endif // STREAM_HH_INCLUDED
@@ -0,0 +1,139 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "synth.hh"
+
+#include <stdexcept>
+#include <utility>
+
+dl::pair_generator::pair_generator(const synth_params &params,
+                                   std::uint64_t seed,
+                                   std::uint64_t stream):
+  params_(params),
+  first_(params.alphabet > 26 ? '!' : 'A'),
+  // mix(0) is zero, so stream zero starts at the seed itself
+  state_(seed + mix(stream))
+{
+  if (params.min_edits > params.max_edits) {
+    throw std::invalid_argument("the fewest edits exceeds the most");
+  }
+  if (0 == params.alphabet || params.alphabet > 94) {
+    throw std::invalid_argument("the alphabet must have from one to 94 "
+                                "characters");
+  }
+}
+
+std::size_t
+dl::pair_generator::operator()(std::string &A, std::string &B)
+{
+  std::size_t n = params_.min_edits +
+    uniform(params_.max_edits - params_.min_edits + 1);
+
+  A.resize(params_.length);
+  for (char &c: A) {
+    c = character();
+  }
+
+  B = A;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t m = B.length();
+    if (0 == m) {
+      B.push_back(character());
+    } else if (1 == m) {
+      // make-dl-test-data's editString1_1
+      switch (uniform(3)) {
+      case 0:
+        B.insert(uniform(2), 1, character());
+        break;
+      case 1:
+        B.clear();
+        break;
+      default:
+        B[0] = character();
+      }
+    } else {
+      // & its editString1_2
+      switch (uniform(4)) {
+      case 0:
+        B.insert(uniform(m + 1), 1, character());
+        break;
+      case 1:
+        B.erase(uniform(m), 1);
+        break;
+      case 2:
+        B[uniform(m)] = character();
+        break;
+      default: {
+        std::size_t j = uniform(m - 1);
+        std::swap(B[j], B[j + 1]);
+      }
+      }
+    }
+  }
+
+  return n;
+}
+
+std::size_t
+dl::pair_generator::uniform(std::size_t n)
+{
+  // Lemire's method: the high word of x * n is uniform over [0, n) once the
+  // few x whose low word falls below 2^64 mod n are rejected, & that takes a
+  // division only when the low word is below n to begin with
+  std::uint64_t x = next(), lo = x * n;
+  if (lo < n) {
+    std::uint64_t limit = -std::uint64_t(n) % n;
+    while (lo < limit) {
+      x = next();
+      lo = x * n;
+    }
+  }
+  return mulhi(x, n);
+}
+
+std::uint64_t
+dl::pair_generator::next()
+{
+  return mix(state_ += UINT64_C(0x9e3779b97f4a7c15));
+}
+
+std::uint64_t
+dl::pair_generator::mulhi(std::uint64_t x, std::uint64_t y)
+{
+# ifdef __SIZEOF_INT128__
+  return (std::uint64_t) (((unsigned __int128) x * y) >> 64);
+# else
+  std::uint64_t x0 = x & 0xffffffff, x1 = x >> 32;
+  std::uint64_t y0 = y & 0xffffffff, y1 = y >> 32;
+  std::uint64_t t = x1 * y0 + ((x0 * y0) >> 32);
+  std::uint64_t u = x0 * y1 + (t & 0xffffffff);
+  return x1 * y1 + (t >> 32) + (u >> 32);
+# endif
+}
+
+std::uint64_t
+dl::pair_generator::mix(std::uint64_t z)
+{
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+char
+dl::pair_generator::character()
+{
+  return char(first_ + uniform(params_.alphabet));
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef SYNTH_HH_INCLUDED
+#define SYNTH_HH_INCLUDED 1
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dl {
+
+  /// The shape of the pairs made by a dl::pair_generator
+  struct synth_params {
+    /// The length of the first string of each pair
+    std::size_t length = 5;
+    /// The fewest edits made to the first string to get the second
+    std::size_t min_edits = 1;
+    /// The most edits made to the first string to get the second
+    std::size_t max_edits = 4;
+    /// The number of distinct characters, from one to 94
+    std::size_t alphabet = 26;
+  };
+
+  /**
+   * \brief Make pairs of strings a known number of edits apart
+   *
+   *
+   * This is a port of the generator in admin/make-dl-test-data, for those
+   * who want test data without a Haskell toolchain, or want a great deal of
+   * it without writing it out & parsing it back in. Each pair is made the
+   * same way:
+   *
+   * 1. a number of edits, n, is drawn uniformly from [min_edits, max_edits]
+   * 2. the first string is drawn uniformly from the alphabet
+   * 3. the second starts out as a copy of the first & is edited n times;
+   *    each edit is equally likely to insert a random character at a random
+   *    position, erase a random character, overwrite a random character with
+   *    a random character (possibly itself) or transpose two random adjacent
+   *    characters. An empty string gains a character, & a string of one
+   *    character can't be transposed, as in make-dl-test-data.
+   *
+   * Since edits may undo one another, n is only an upper bound on the
+   * unrestricted distance between the two strings. It's not even that on
+   * the restricted distance, since a later edit may land between two
+   * characters an earlier one transposed.
+   *
+   * An alphabet of up to 26 characters is drawn from the letters "A", "B" &
+   * so on; a larger one from the printable ASCII characters, starting with
+   * "!". Either way, the strings may be written out one pair to a line, tab
+   * separated, as a corpus for `dl'.
+   *
+   * The pairs are entirely determined by the parameters, the seed & the
+   * stream, on any platform: the generator is SplitMix64, & doesn't depend
+   * on the standard library's distributions, whose output is
+   * implementation-defined. Generators given the same seed but different
+   * streams start at unrelated points in its sequence, so that a workload
+   * may be divided among threads (each making its share of the pairs from a
+   * stream of its own) & still come out the same however many there are.
+   *
+   *
+   */
+
+  class pair_generator
+  {
+  public:
+    /// Throws std::invalid_argument if \a params doesn't describe a
+    /// workload (min_edits exceeds max_edits, or the alphabet is empty or
+    /// too large)
+    pair_generator(const synth_params &params,
+                   std::uint64_t seed,
+                   std::uint64_t stream = 0);
+
+  public:
+    /// Make the next pair in \a A & \a B (whose capacity is re-used),
+    /// returning the number of edits made
+    std::size_t operator()(std::string &A, std::string &B);
+
+  private:
+    /// SplitMix64's output function
+    static std::uint64_t mix(std::uint64_t z);
+    /// Return the high word of the product of \a x & \a y
+    static std::uint64_t mulhi(std::uint64_t x, std::uint64_t y);
+    /// Return the next number in the sequence
+    std::uint64_t next();
+    /// Return a number uniformly distributed over [0, n)
+    std::size_t uniform(std::size_t n);
+    /// Return a character uniformly distributed over the alphabet
+    char character();
+
+  private:
+    synth_params params_;
+    char first_;
+    std::uint64_t state_;
+  };
+
+} // namespace dl
+
+#endif // SYNTH_HH_INCLUDED
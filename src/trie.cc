@@ -0,0 +1,247 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "trie.hh"
+#include "alphabet.hh"
+
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+template <typename CharT>
+void
+dl::basic_trie<CharT>::build()
+{
+  using namespace std;
+
+  size_t n = size();
+  if (n > numeric_limits<uint32_t>::max() ||
+      text_.size() >= numeric_limits<uint32_t>::max()) {
+    throw length_error("too many words for a trie");
+  }
+
+  // Sort the words; the words beneath any node are then contiguous, with
+  // those ending at that node first...
+  vector<uint32_t> ids(n);
+  iota(ids.begin(), ids.end(), uint32_t(0));
+  stable_sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+    return word(a) < word(b);
+  });
+  for (size_t i = 0; i < n; ++i) {
+    max_len_ = max(max_len_, word(i).length());
+  }
+
+  // so the trie can be laid out depth-first by walking that order. Each
+  // frame on the stack is a node whose children are still being added,
+  // along with the words beneath it not yet placed in a child.
+  struct frame {
+    uint32_t x;
+    size_t cur, hi;
+  };
+  vector<node> nodes;
+  vector<CharT> chars;
+  auto terminal = [&](uint32_t x, size_t lo, size_t hi, size_t depth) {
+    size_t i = lo;
+    while (i < hi && word(ids[i]).length() == depth) ++i;
+    nodes[x].w0 = (uint32_t)lo;
+    nodes[x].w1 = (uint32_t)i;
+    return i;
+  };
+
+  vector<frame> stack;
+  nodes.push_back(node{0, 0, 0, 0});
+  chars.push_back(CharT(0));
+  stack.push_back(frame{0, terminal(0, 0, n, 0), n});
+  while (!stack.empty()) {
+    frame &f = stack.back();
+    if (f.cur == f.hi) {
+      nodes[f.x].end = (uint32_t)nodes.size();
+      stack.pop_back();
+      continue;
+    }
+    // Every word in [f.cur, f.hi) is longer than this node's prefix; the
+    // next child takes those continuing with the same character.
+    uint32_t depth = nodes[f.x].depth;
+    CharT c = word(ids[f.cur])[depth];
+    size_t lo = f.cur, hi = lo + 1;
+    while (hi < f.hi && word(ids[hi])[depth] == c) ++hi;
+    f.cur = hi;
+    uint32_t x = (uint32_t)nodes.size();
+    nodes.push_back(node{depth + 1, 0, 0, 0});
+    chars.push_back(c);
+    stack.push_back(frame{x, terminal(x, lo, hi, depth + 1), hi});
+  }
+
+  nodes_.assign(move(nodes));
+  chars_.assign(move(chars));
+  ids_.assign(move(ids));
+}
+
+template <typename CharT>
+dl::basic_trie<CharT>::basic_trie(const index_file &f)
+{
+  f.expect(index_kind::trie, sizeof(CharT));
+  f.section(0, text_);
+  f.section(1, offsets_);
+  f.section(2, nodes_);
+  f.section(3, chars_);
+  f.section(4, ids_);
+  max_len_ = f.param(0);
+  if (offsets_.empty() || offsets_.back() != text_.size() ||
+      nodes_.empty() || chars_.size() != nodes_.size() ||
+      ids_.size() != size()) {
+    throw std::runtime_error("malformed trie");
+  }
+}
+
+template <typename CharT>
+void
+dl::basic_trie<CharT>::save(const std::string &pth) const
+{
+  write_index_file(pth, index_kind::trie, sizeof(CharT),
+                   {(std::uint64_t)max_len_},
+                   {text_, offsets_, nodes_, chars_, ids_});
+}
+
+template <typename CharT>
+void
+dl::basic_trie<CharT>::search(view_type q,
+                              std::size_t max_k,
+                              std::vector<match> &out,
+                              workspace &ws,
+                              search_stats *stats) const
+{
+  using namespace std;
+
+  size_t nQ = q.length();
+  // As in dl::lowrance_wagner, the -1 row & column are INF.
+  size_t INF = max_len_ + nQ + 1;
+
+  // Row i of the recurrence for the current path is at H[i*W]; only the rows
+  // for the path's nodes are ever live. Trie characters are the A side of
+  // the recurrence & the query the B side, so `DA' maps characters of the
+  // path to the depth at which they last appeared-- but it's only ever
+  // consulted for characters of the query. So each query character is given
+  // a rank in 1..s by `R', & DA is an array indexed by rank. Along with it
+  // is kept, for each depth, the rank of the character at that depth & the
+  // DA entry it displaced, so that the walk can restore DA on backing out.
+  size_t W = nQ + 1;
+  size_t nR = detail::char_map<CharT>::scratch_words(q);
+  size_t nwords = (max_len_ + 1)*W + (nQ + 1) + 2*(max_len_ + 1) + nQ + nR;
+  size_t *H = ws.reserve<size_t>(nwords);
+  size_t *DA = H + (max_len_ + 1)*W;
+  size_t *undo_rank = DA + nQ + 1;
+  size_t *undo_da = undo_rank + max_len_ + 1;
+  size_t *rank = undo_da + max_len_ + 1;
+  detail::char_map<CharT> R(rank + nQ, nR);
+
+  size_t s = 0;
+  for (size_t j = 0; j < nQ; ++j) {
+    size_t r = R.get(q[j]);
+    if (0 == r) {
+      r = ++s;
+      R.set(q[j], r);
+    }
+    rank[j] = r;
+  }
+  for (size_t r = 0; r <= s; ++r) {
+    DA[r] = 0;
+  }
+
+  for (size_t j = 0; j <= nQ; ++j) {
+    H[j] = j;
+  }
+  if (nQ <= max_k) {
+    for (uint32_t w = nodes_[0].w0; w < nodes_[0].w1; ++w) {
+      out.push_back(match{ids_[w], nQ});
+    }
+  }
+
+  size_t rows = 0;
+  // The depth of the deepest node whose DA update is in effect
+  size_t top = 0;
+  for (uint32_t x = 1; x < nodes_.size(); ) {
+    const node &N = nodes_[x];
+    CharT c = chars_[x];
+    size_t i = N.depth, im1 = i - 1;
+    for ( ; top >= i; --top) {
+      if (undo_rank[top]) DA[undo_rank[top]] = undo_da[top];
+    }
+
+    size_t *Hi = H + i*W, *Him1 = Hi - W;
+    Hi[0] = i;
+    size_t DB = 0, row_min = i;
+    for (size_t j = 1; j <= nQ; ++j) {
+      size_t i1 = DA[rank[j-1]];
+      size_t j1 = DB;
+      size_t d = 0;
+      if (c != q[j-1]) {
+        d = 1;
+      } else {
+        DB = j;
+      }
+      size_t h1 = Him1[j - 1] + d;
+      size_t h2 = Hi[j - 1] + 1;
+      size_t h3 = Him1[j] + 1;
+      size_t h4 = INF;
+      if (i1 > 0 && j1 > 0) {
+        h4 = H[(i1-1)*W + j1-1] + (im1-i1) + 1 + (j-j1-1);
+      }
+      if (h2 < h1) h1 = h2;
+      if (h3 < h1) h1 = h3;
+      if (h4 < h1) h1 = h4;
+      Hi[j] = h1;
+      if (h1 < row_min) row_min = h1;
+    }
+    ++rows;
+
+    if (row_min > max_k) {
+      x = N.end;
+      continue;
+    }
+    if (Hi[nQ] <= max_k) {
+      for (uint32_t w = N.w0; w < N.w1; ++w) {
+        out.push_back(match{ids_[w], Hi[nQ]});
+      }
+    }
+    size_t r = R.get(c);
+    undo_rank[i] = r;
+    if (r) {
+      undo_da[i] = DA[r];
+      DA[r] = i;
+    }
+    top = i;
+    ++x;
+  }
+
+  if (stats) {
+    ++stats->queries;
+    stats->evaluations += rows;
+    stats->entries += text_.size();
+  }
+}
+
+template <typename CharT>
+std::vector<dl::match>&
+dl::basic_trie<CharT>::matches_buffer()
+{
+  static thread_local std::vector<match> M;
+  return M;
+}
+
+template class dl::basic_trie<char>;
+template class dl::basic_trie<char16_t>;
+template class dl::basic_trie<char32_t>;
@@ -0,0 +1,205 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef TRIE_HH_INCLUDED
+#define TRIE_HH_INCLUDED 1
+
+#include "index_file.hh"
+#include "query.hh"
+#include "workspace.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dl {
+
+  /**
+   * \brief A trie: an index over a dictionary of words supporting "find all
+   * words within distance k of this one" by sharing work between words with
+   * common prefixes
+   *
+   *
+   * Comparing a query against each word of a dictionary in turn computes the
+   * recurrence of Lowrance & Wagner afresh for every word, although row i of
+   * the matrix depends only on the query & the first i characters of the
+   * word. Words sharing a prefix therefore share the rows for that prefix.
+   * This index arranges the dictionary in a trie & walks it depth-first,
+   * computing one row per node from the rows of that node's ancestors (which
+   * are kept, one per depth, for as long as the walk remains beneath them).
+   * A word's distance is the last entry of the row at the node at which it
+   * ends.
+   *
+   * The transposition term of the unrestricted recurrence reaches back to the
+   * row after the last occurrence of a query character along the current
+   * path, so the "DA" bookkeeping of dl::lowrance_wagner is kept for the path
+   * as well, & undone as the walk backs out of each node.
+   *
+   * The minimum over a row never decreases from one row to the next, so once
+   * every entry in a node's row exceeds k, no word beneath that node can be
+   * within k of the query & the whole subtree is skipped. For small k, only a
+   * small part of the trie is ever visited.
+   *
+   * The distances are unrestricted, as for dl::bk_tree; the results are
+   * exactly those a linear scan with dl::lowrance_wagner_within would produce.
+   *
+   * The trie is built once, from a range of words, & laid out depth-first in
+   * a single array with no pointers: a node's first child immediately follows
+   * it, & each node records the index just past its subtree (which is where
+   * its next sibling, if any, begins). The words themselves are concatenated
+   * in one string. Duplicate words are kept, & reported separately. Since
+   * nothing in the trie is a pointer, it may be saved to disk & mapped back
+   * in (see dl::index_file).
+   *
+   * A trie is immutable once constructed & so may be shared between threads,
+   * each of which should supply its own workspace.
+   *
+   * Strings of char are compared byte by byte; use basic_trie<char32_t>
+   * (u32trie) to compare decoded text (see dl::utf8_decode).
+   *
+   *
+   */
+
+  template <typename CharT>
+  class basic_trie
+  {
+  public:
+    typedef std::basic_string_view<CharT> view_type;
+
+  public:
+    /// Index the words in [\a p0, \a p1) (each convertible to view_type);
+    /// throws std::length_error if there are too many
+    template <typename FII>
+    basic_trie(FII p0, FII p1)
+    {
+      std::vector<CharT> text;
+      std::vector<std::uint64_t> offsets(1, 0);
+      for ( ; p0 != p1; ++p0) {
+        view_type w(*p0);
+        text.insert(text.end(), w.begin(), w.end());
+        offsets.push_back(text.size());
+      }
+      text_.assign(std::move(text));
+      offsets_.assign(std::move(offsets));
+      build();
+    }
+    /// Load a trie saved to \a f, which must outlive it; throws
+    /// std::runtime_error if \a f holds some other sort of index
+    explicit basic_trie(const index_file &f);
+
+  public:
+    /// Save this trie to \a pth (see dl::index_file); throws
+    /// std::system_error on failure
+    void save(const std::string &pth) const;
+
+  public:
+    /// Return the number of words in the dictionary
+    std::size_t size() const {
+      return offsets_.size() - 1;
+    }
+    /// Return the \a i-th word given at construction
+    view_type word(std::size_t i) const {
+      return view_type(text_.data() + offsets_[i],
+                       offsets_[i+1] - offsets_[i]);
+    }
+    /// Return the number of nodes in the trie (including the root)
+    std::size_t nodes() const {
+      return nodes_.size();
+    }
+
+    /**
+     * \brief Find the words within a given distance of a query
+     *
+     *
+     * \param q [in] the query
+     *
+     * \param max_k [in] the largest distance of interest to the caller
+     *
+     * \param pout [in] a forward output iterator to which a dl::match shall be
+     * written for each word no more than \a max_k from \a q (in no particular
+     * order); each match's index is the word's position in the range from
+     * which the trie was built
+     *
+     * \param ws [in,out] the workspace in which to carry-out the search
+     *
+     * \param stats [in,out] if non-null, the cost of this search (in rows of
+     * the recurrence) will be added to it
+     *
+     * \return \a pout, advanced past the last match written
+     *
+     *
+     */
+
+    template <typename FOI>
+    FOI
+    range_query(view_type q,
+                std::size_t max_k,
+                FOI pout,
+                workspace &ws,
+                search_stats *stats = nullptr) const
+    {
+      std::vector<match> &M = matches_buffer();
+      M.clear();
+      search(q, max_k, M, ws, stats);
+      return std::copy(M.begin(), M.end(), pout);
+    }
+
+  private:
+    void build();
+    void search(view_type q,
+                std::size_t max_k,
+                std::vector<match> &out,
+                workspace &ws,
+                search_stats *stats) const;
+    static std::vector<match>& matches_buffer();
+
+  private:
+    struct node {
+      /// This node's depth (i.e. the length of its prefix)
+      std::uint32_t depth;
+      /// The index in nodes_ just past this node's subtree
+      std::uint32_t end;
+      /// The words ending at this node are ids_[w0, w1)
+      std::uint32_t w0, w1;
+    };
+
+    /// The words, end-to-end; word i is text_[offsets_[i], offsets_[i+1])
+    index_array<CharT> text_;
+    index_array<std::uint64_t> offsets_;
+    /// The trie, depth-first; the root (the empty prefix) is nodes_[0]
+    index_array<node> nodes_;
+    /// The last character of the prefix at each node (kept apart from the
+    /// nodes so that they have no padding to write to disk)
+    index_array<CharT> chars_;
+    /// The indices of the words, in lexicographic order
+    index_array<std::uint32_t> ids_;
+    /// The length of the longest word
+    std::size_t max_len_ = 0;
+  };
+
+  typedef basic_trie<char> trie;
+  typedef basic_trie<char16_t> u16trie;
+  typedef basic_trie<char32_t> u32trie;
+
+  extern template class basic_trie<char>;
+  extern template class basic_trie<char16_t>;
+  extern template class basic_trie<char32_t>;
+
+} // namespace dl
+
+#endif // TRIE_HH_INCLUDED
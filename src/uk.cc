@@ -16,30 +16,35 @@
 #include "config.h"
 #include "uk.hh"
 
-#include <iostream>
+#include <algorithm>
+#include <limits>
 
 namespace {
 
+  /// Compute f(k,p) by Algorithm (8) (with the transposition case of section
+  /// 4), given \a fp, the column of f(.,p-1), indexed by diagonal (if
+  /// \a CountWork, the number of matching characters slid over is added to
+  /// \a slides)
+  template <bool CountWork, typename CharT>
   ptrdiff_t
-  algo_8(const std::string &A,
+  algo_8(std::basic_string_view<CharT> A,
          ptrdiff_t m,
-         const std::string &B,
+         std::basic_string_view<CharT> B,
          ptrdiff_t n,
          ptrdiff_t inf,
          ptrdiff_t k,
-         ptrdiff_t p,
-         size_t num_p,
-         ptrdiff_t *f)
+         const ptrdiff_t *fp,
+         std::size_t &slides)
   {
-    ptrdiff_t t  = f[num_p*(k+m)+(p)] + 1;    // f(k,p-1) + 1
+    ptrdiff_t t  = fp[k] + 1;       // f(k,p-1) + 1
     ptrdiff_t t1 = -inf;
-    if (k+m>=1 && p >=0 ) {
-      t1 = f[num_p*(k+m-1)+(p)];
+    if (k+m >= 1) {
+      t1 = fp[k-1];                 // f(k-1,p-1)
     }
 
     ptrdiff_t t2 = -inf;
-    if (k < n && p < inf + 2) {
-      t2 = f[num_p*(k+m+1)+(p)] + 1;  // f(k+1,p-1) + 1
+    if (k < n) {
+      t2 = fp[k+1] + 1;             // f(k+1,p-1) + 1
     }
 
     // check whether a(t)a(t+1) = b(k+t+1)b(k+t), but *only* if those
@@ -69,9 +74,11 @@ namespace {
       t = t3;
     }
     // while a(t+1) = b(t+1+k) do t := t + 1
+    ptrdiff_t t0 = t;
     while (t + 1 <= m &&
            t + k + 1 <= n &&
            A[t] == B[t + k]) t++;
+    if constexpr (CountWork) slides += t - t0;
 
     if (t > m || t + k > n) {
       t = inf;
@@ -79,66 +86,204 @@ namespace {
 
     return t;
   }
-}
 
-bool
-ukkonen(const std::string &A,
-        const std::string &B,
-        std::size_t D,
-        bool verb)
-{
-  using namespace std;
+  template <bool CountWork, typename CharT>
+  std::size_t
+  uk(std::basic_string_view<CharT> A,
+     std::basic_string_view<CharT> B,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    using namespace std;
 
-  ptrdiff_t m = A.length();
-  ptrdiff_t n = B.length();
-  ptrdiff_t inf = max(m, n); // |A,B| <= inf
+    ptrdiff_t m = A.length();
+    ptrdiff_t n = B.length();
+    ptrdiff_t inf = max(m, n); // |A,B| <= inf
 
-  // Allocating too much space, here. This implementation won't satisfy the
-  // space bounds.
+    // The work done is tallied in locals & only handed to the workspace on
+    // the way out
+    size_t diagonals = 0, slides = 0;
+    auto done = [&](size_t d) {
+      if constexpr (CountWork) {
+        dl::work_stats work;
+        work.comparisons = 1;
+        work.diagonals = diagonals;
+        work.slides = slides;
+        ws.add_work(work);
+      }
+      return d;
+    };
 
-  // To index into `f' in terms of (i,j), -m <= i <= n,
-  // -1 <=j <= inf, do f[i+m][j+1]
-  ptrdiff_t f[(m+n+1)*(inf+2)];
-  for (ptrdiff_t i = 0; i < m + n + 1; ++i) {
-    for (ptrdiff_t j = 0; j < inf + 2; ++j) {
-      f[i*(inf+2)+j] = -inf - 1;
+    // The distance is at least the difference in lengths...
+    if ((size_t)(m > n ? m - n : n - m) > max_k) {
+      return done(max_k + 1);
     }
-  }
 
-  // Initialize f: f(k,|k|-1) = |k|-1, if k < 0...
-  for (ptrdiff_t k = -1; k >= -m; --k) {
-    f[(k+m)*(inf+2)-k] = -k - 1;
-  }
-  for (ptrdiff_t k = 0; k <= n; ++k) {
-    f[(k+m)*(inf+2)+k] = -1;
-  }
+    // Column p of f is computed from column p-1 alone, so only two columns
+    // are kept. Column p covers the diagonals -p..p (clipped to -m..n), &
+    // p never exceeds the distance (which is at most inf) or max_k, so the
+    // columns need only cover the diagonals within one more than that of the
+    // main diagonal: O(min(s,m) + min(s,n)) cells in all, where s is the
+    // lesser of the distance & max_k.
+    ptrdiff_t P = (size_t)inf < max_k ? inf : (ptrdiff_t)max_k;
+    ptrdiff_t lo = min(m, P + 1), hi = min(n, P + 1);
+    ptrdiff_t W = lo + hi + 1;
+    ptrdiff_t *f = ws.reserve<ptrdiff_t>(2*W);
+    // fp[k] is f(k,p-1) & fc[k] is f(k,p)
+    ptrdiff_t *fp = f + lo, *fc = f + W + lo;
 
-  ptrdiff_t p = -1;
-  ptrdiff_t r = p - min(m, n);
-  while (f[n*(inf+2)+p+1] != m) {
-    p = p + 1;
-    r = r + 1;
-    if (r <= 0) {
-      for (ptrdiff_t k = -p; k <= p; ++k) {
-        // f(k,p)
-        f[(inf+2)*(k+m)+p+1] = algo_8(A, m, B, n, inf, k, p, inf+2, (ptrdiff_t*)f);
+    // The only cells of column p-1 read before they're written (besides
+    // those computed in it) are f(k,|k|-1) for |k| = p, which are
+    // initialized to |k|-1 if k < 0 & to -1 otherwise, & f(k,|k|-2) for
+    // |k| = p+1, which are -inf; each is set just before column p is
+    // computed. Cells of column p-1 between -r & r (see below) are stale, but
+    // never read.
+    ptrdiff_t d = n - m;
+    for (ptrdiff_t p = 0; ; ++p) {
+      if ((size_t)p > max_k) {
+        return done(max_k + 1);
       }
-    } else {
-      for (ptrdiff_t k = max(-m, -p); k <= -r; ++k) {
-        // f(k,p)
-        f[(inf+2)*(k+m)*p+1] = algo_8(A, m, B, n, inf, k, p, inf+2, (ptrdiff_t*)f);
+      if (p <= m) fp[-p] = p - 1;
+      if (p <= n) fp[p] = -1;
+      if (p + 1 <= lo) fp[-p-1] = -inf - 1;
+      if (p + 1 <= hi) fp[p+1] = -inf - 1;
+
+      // Ukkonen shows that once r = p - min(m,n) is positive, the diagonals
+      // strictly between -r & r can't lie on an optimal path.
+      ptrdiff_t r = p - min(m, n);
+      if (r <= 0) {
+        for (ptrdiff_t k = max(-m, -p); k <= min(n, p); ++k) {
+          fc[k] = algo_8<CountWork>(A, m, B, n, inf, k, fp, slides);
+          ++diagonals;
+        }
+      } else {
+        for (ptrdiff_t k = max(-m, -p); k <= -r; ++k) {
+          fc[k] = algo_8<CountWork>(A, m, B, n, inf, k, fp, slides);
+          ++diagonals;
+        }
+        for (ptrdiff_t k = r; k <= min(n, p); ++k) {
+          fc[k] = algo_8<CountWork>(A, m, B, n, inf, k, fp, slides);
+          ++diagonals;
+        }
       }
-      for (ptrdiff_t k = r; k <= max(n, p); ++k) {
-        // f(k,p)
-        f[(inf+2)*(k+m)+p+1] = algo_8(A, m, B, n, inf, k, p,  inf+2, (ptrdiff_t*)f);
+
+      // Diagonal n-m is always among those computed, once p reaches |n-m|
+      if ((d < 0 ? -d : d) <= p && fc[d] == m) {
+        return done(p);
       }
+      swap(fp, fc);
     }
   }
 
-  size_t d = p;
-
-  if (verb) {
-    cout << "Computed distance: " << d << endl;
+  /// Counting the work done costs several percent on short strings, so it's
+  /// compiled into an instantiation of its own, used only when asked for
+  template <typename CharT>
+  std::size_t
+  uk(std::basic_string_view<CharT> A,
+     std::basic_string_view<CharT> B,
+     std::size_t max_k,
+     dl::workspace &ws)
+  {
+    return ws.work() ? uk<true>(A, B, max_k, ws) : uk<false>(A, B, max_k, ws);
   }
-  return d == D;
+
+}
+
+std::size_t
+dl::ukkonen(std::string_view A,
+            std::string_view B)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen(std::string_view A,
+            std::string_view B,
+            workspace &ws)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::ukkonen_within(std::string_view A,
+                   std::string_view B,
+                   std::size_t max_k)
+{
+  return uk(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen_within(std::string_view A,
+                   std::string_view B,
+                   std::size_t max_k,
+                   workspace &ws)
+{
+  return uk(A, B, max_k, ws);
+}
+
+std::size_t
+dl::ukkonen(std::u16string_view A,
+            std::u16string_view B)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen(std::u16string_view A,
+            std::u16string_view B,
+            workspace &ws)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::ukkonen_within(std::u16string_view A,
+                   std::u16string_view B,
+                   std::size_t max_k)
+{
+  return uk(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen_within(std::u16string_view A,
+                   std::u16string_view B,
+                   std::size_t max_k,
+                   workspace &ws)
+{
+  return uk(A, B, max_k, ws);
+}
+
+std::size_t
+dl::ukkonen(std::u32string_view A,
+            std::u32string_view B)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(),
+            this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen(std::u32string_view A,
+            std::u32string_view B,
+            workspace &ws)
+{
+  return uk(A, B, std::numeric_limits<std::size_t>::max(), ws);
+}
+
+std::size_t
+dl::ukkonen_within(std::u32string_view A,
+                   std::u32string_view B,
+                   std::size_t max_k)
+{
+  return uk(A, B, max_k, this_thread_workspace());
+}
+
+std::size_t
+dl::ukkonen_within(std::u32string_view A,
+                   std::u32string_view B,
+                   std::size_t max_k,
+                   workspace &ws)
+{
+  return uk(A, B, max_k, ws);
 }
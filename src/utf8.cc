@@ -0,0 +1,121 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "utf8.hh"
+
+std::size_t
+dl::utf8_decode(std::string_view s,
+                std::u32string &out)
+{
+  using namespace std;
+
+  const char32_t REPLACEMENT = 0xfffd;
+
+  out.clear();
+  out.reserve(s.length());
+
+  size_t num_bad = 0;
+  const unsigned char *p = reinterpret_cast<const unsigned char*>(s.data());
+  const unsigned char *end = p + s.length();
+  while (p < end) {
+    unsigned char c = *p++;
+    if (c < 0x80) {
+      out.push_back(c);
+      continue;
+    }
+    // Work out the number of continuation bytes & the range of values allowed
+    // for the first of them (Table 3-7 of the Unicode Standard); the
+    // restrictions on the first continuation byte are what rule out overlong
+    // encodings, surrogates & values beyond U+10FFFF.
+    size_t n;
+    unsigned char lo = 0x80, hi = 0xbf;
+    char32_t cp;
+    if (c >= 0xc2 && c <= 0xdf) {
+      n = 1;
+      cp = c & 0x1f;
+    } else if (c >= 0xe0 && c <= 0xef) {
+      n = 2;
+      cp = c & 0x0f;
+      if (0xe0 == c) {
+        lo = 0xa0;
+      } else if (0xed == c) {
+        hi = 0x9f;
+      }
+    } else if (c >= 0xf0 && c <= 0xf4) {
+      n = 3;
+      cp = c & 0x07;
+      if (0xf0 == c) {
+        lo = 0x90;
+      } else if (0xf4 == c) {
+        hi = 0x8f;
+      }
+    } else {
+      out.push_back(REPLACEMENT);
+      ++num_bad;
+      continue;
+    }
+    // A sequence that goes wrong part-way through is replaced as a whole, but
+    // the offending byte is left to start the next one
+    size_t i = 0;
+    for ( ; i < n && p < end && *p >= lo && *p <= hi; ++i, ++p) {
+      cp = (cp << 6) | (*p & 0x3f);
+      lo = 0x80;
+      hi = 0xbf;
+    }
+    if (i == n) {
+      out.push_back(cp);
+    } else {
+      out.push_back(REPLACEMENT);
+      ++num_bad;
+    }
+  }
+
+  return num_bad;
+}
+
+std::u32string
+dl::utf8_decode(std::string_view s)
+{
+  std::u32string out;
+  utf8_decode(s, out);
+  return out;
+}
+
+void
+dl::utf8_encode(std::u32string_view s,
+                std::string &out)
+{
+  for (char32_t c: s) {
+    if ((c >= 0xd800 && c <= 0xdfff) || c > 0x10ffff) {
+      c = 0xfffd;
+    }
+    if (c < 0x80) {
+      out.push_back((char)c);
+    } else if (c < 0x800) {
+      out.push_back((char)(0xc0 | (c >> 6)));
+      out.push_back((char)(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+      out.push_back((char)(0xe0 | (c >> 12)));
+      out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+      out.push_back((char)(0x80 | (c & 0x3f)));
+    } else {
+      out.push_back((char)(0xf0 | (c >> 18)));
+      out.push_back((char)(0x80 | ((c >> 12) & 0x3f)));
+      out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+      out.push_back((char)(0x80 | (c & 0x3f)));
+    }
+  }
+}
@@ -0,0 +1,69 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef UTF8_HH_INCLUDED
+#define UTF8_HH_INCLUDED 1
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace dl {
+
+  /**
+   * \brief Decode a string of UTF-8 into Unicode code points
+   *
+   *
+   * \param s [in] the UTF-8 to be decoded
+   *
+   * \param out [out] on return, the code points encoded in \a s; any prior
+   * contents are discarded (but its capacity is retained, so that a caller
+   * decoding many strings can re-use it)
+   *
+   * \return the number of ill-formed sequences found in \a s
+   *
+   *
+   * The Damerau-Levenshtein distance between two strings of UTF-8 computed
+   * byte-by-byte is not, in general, the distance between the text they
+   * encode: substituting "é" for "e" is one edit, but changes two bytes. The
+   * results of this function may be handed to the std::u32string_view
+   * overloads of any of the algorithms to get the latter.
+   *
+   * Decoding is not validation: each ill-formed sequence (a stray continuation
+   * byte, a truncated sequence, an overlong encoding, a surrogate or a value
+   * beyond U+10FFFF) is replaced with U+FFFD REPLACEMENT CHARACTER, one per
+   * maximal subpart, as recommended in section 3.9 of the Unicode Standard.
+   *
+   *
+   */
+
+  std::size_t
+  utf8_decode(std::string_view s,
+              std::u32string &out);
+
+  /// Decode the UTF-8 in \a s into Unicode code points, replacing ill-formed
+  /// sequences with U+FFFD
+  std::u32string
+  utf8_decode(std::string_view s);
+
+  /// Encode the code points in \a s as UTF-8, appending them to \a out;
+  /// surrogates & values beyond U+10FFFF are encoded as U+FFFD
+  void
+  utf8_encode(std::u32string_view s,
+              std::string &out);
+
+} // namespace dl
+
+#endif // UTF8_HH_INCLUDED
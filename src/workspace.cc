@@ -0,0 +1,91 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#include "config.h"
+#include "workspace.hh"
+
+#include <new>
+#include <utility>
+
+dl::work_stats&
+dl::work_stats::operator+=(const work_stats &that)
+{
+  comparisons += that.comparisons;
+  cells += that.cells;
+  diagonals += that.diagonals;
+  slides += that.slides;
+  return *this;
+}
+
+dl::workspace::workspace():
+  buf_(nullptr), cap_(0), work_(nullptr)
+{ }
+
+dl::workspace::workspace(std::size_t nbytes):
+  buf_(nullptr), cap_(0), work_(nullptr)
+{
+  reserve_bytes(nbytes);
+}
+
+dl::workspace::workspace(workspace &&that) noexcept:
+  buf_(that.buf_), cap_(that.cap_), work_(that.work_)
+{
+  that.buf_ = nullptr;
+  that.cap_ = 0;
+  that.work_ = nullptr;
+}
+
+dl::workspace::~workspace()
+{
+  if (buf_) {
+    ::operator delete(buf_, std::align_val_t(ALIGNMENT));
+  }
+}
+
+dl::workspace&
+dl::workspace::operator=(workspace &&that) noexcept
+{
+  std::swap(buf_, that.buf_);
+  std::swap(cap_, that.cap_);
+  std::swap(work_, that.work_);
+  return *this;
+}
+
+void*
+dl::workspace::reserve_bytes(std::size_t nbytes)
+{
+  if (nbytes > cap_) {
+    // Grow geometrically, so that a corpus whose strings get steadily longer
+    // doesn't cause an allocation on every comparison. There's no need to
+    // copy the old contents over, since callers can't rely on them anyway.
+    std::size_t cap = cap_ + cap_;
+    if (cap < nbytes) cap = nbytes;
+    cap = (cap + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    void *buf = ::operator new(cap, std::align_val_t(ALIGNMENT));
+    if (buf_) {
+      ::operator delete(buf_, std::align_val_t(ALIGNMENT));
+    }
+    buf_ = buf;
+    cap_ = cap;
+  }
+  return buf_;
+}
+
+dl::workspace&
+dl::this_thread_workspace()
+{
+  thread_local workspace ws;
+  return ws;
+}
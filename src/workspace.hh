@@ -0,0 +1,148 @@
+// Copyright (C) 2020-2024 Michael Herstine <sp1ff@pobox.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at
+// your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see https://www.gnu.org/licenses/.
+
+#ifndef WORKSPACE_HH_INCLUDED
+#define WORKSPACE_HH_INCLUDED 1
+
+#include <cstddef>
+
+namespace dl {
+
+  /// The work done by the algorithms in the course of one or more
+  /// comparisons (see workspace::count_work)
+  struct work_stats {
+    /// The number of comparisons made
+    std::size_t comparisons = 0;
+    /// Cells of the recurrence relation computed, by Lowrance & Wagner or
+    /// Hyyrö (who computes them sixty-four at a time, but all the same)
+    std::size_t cells = 0;
+    /// Diagonals extended, by Ukkonen's Algorithm (8) or Berghel & Roach's f
+    std::size_t diagonals = 0;
+    /// Steps taken sliding down those diagonals over matching characters
+    std::size_t slides = 0;
+
+    work_stats& operator+=(const work_stats &that);
+  };
+
+  /**
+   * \brief Scratch memory for computing Damerau-Levenshtein distance
+   *
+   *
+   * Each of the algorithms in this library needs a table whose size depends
+   * on the lengths of the strings being compared. Rather than allocate that
+   * table on the stack (which limits the length of the strings that may be
+   * compared) or the heap (which is slow) on each call, callers may hand the
+   * algorithms a workspace, which owns a single cache-aligned buffer that
+   * grows as needed & is re-used across calls.
+   *
+   * The algorithms make no assumptions about the contents of the buffer when
+   * they begin: each initializes only those cells that the comparison at hand
+   * will read before writing. Consequently, growing the buffer discards its
+   * contents.
+   *
+   * A workspace may not be shared between threads; each thread should have
+   * its own (see this_thread_workspace).
+   *
+   * A workspace can also be asked to tally the work done by the comparisons
+   * made in it, for those wishing to know why one algorithm is faster than
+   * another on their data. Each algorithm counts as it goes in local
+   * variables, & only adds them to the tally as it returns; where counting
+   * would slow the inner loops, the algorithm has a separate instantiation
+   * that counts, used only in workspaces that are counting.
+   *
+   *
+   */
+
+  class workspace
+  {
+  public:
+    /// The alignment, in bytes, of the buffer (a cache line on most
+    /// contemporary CPUs)
+    static const std::size_t ALIGNMENT = 64;
+
+  public:
+    workspace();
+    /// Construct a workspace with at least \a nbytes of capacity
+    explicit workspace(std::size_t nbytes);
+    workspace(const workspace &) = delete;
+    workspace(workspace &&that) noexcept;
+    ~workspace();
+    workspace& operator=(const workspace &) = delete;
+    workspace& operator=(workspace &&that) noexcept;
+
+  public:
+    /// Return the size, in bytes, of the buffer
+    std::size_t capacity() const {
+      return cap_;
+    }
+    /// Add the work done by each subsequent comparison made in this workspace
+    /// to \a stats, until told otherwise (if \a stats is null, stop counting)
+    void count_work(work_stats *stats) {
+      work_ = stats;
+    }
+    /// Return the tally to which work is being added, if any
+    work_stats* work() const {
+      return work_;
+    }
+    /// Add \a w to the tally, if work is being counted
+    void add_work(const work_stats &w) {
+      if (work_) *work_ += w;
+    }
+    /**
+     * \brief Obtain room for \a n objects of type \a T
+     *
+     *
+     * \param n [in] the number of objects for which room is required
+     *
+     * \return a pointer to the start of the buffer, which will be aligned to
+     * ALIGNMENT bytes; it will remain valid until the next call to reserve
+     *
+     *
+     * The contents of the buffer are unspecified; if the buffer needs to
+     * grow, its prior contents will be lost.
+     *
+     *
+     */
+    template <typename T>
+    T* reserve(std::size_t n) {
+      return static_cast<T*>(reserve_bytes(n * sizeof(T)));
+    }
+
+  private:
+    void* reserve_bytes(std::size_t nbytes);
+
+  private:
+    void *buf_;
+    std::size_t cap_;
+    work_stats *work_;
+  };
+
+  /**
+   * \brief Retrieve a workspace private to the calling thread
+   *
+   *
+   * This is the workspace used by each algorithm when the caller doesn't
+   * supply one. It lives as long as the calling thread & retains the largest
+   * buffer needed by any comparison made on that thread.
+   *
+   *
+   */
+
+  workspace&
+  this_thread_workspace();
+
+} // namespace dl
+
+#endif // WORKSPACE_HH_INCLUDED
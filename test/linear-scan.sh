@@ -0,0 +1,19 @@
+# Sourced by the dictionary tests for the reference against which each index
+# is checked: a linear scan, comparing every query with every word.
+#
+# linear_scan WORDS QUERIES ALGO [K]: pair each query in QUERIES with each
+# word in WORDS (skipping blank lines & comments in both), stream the pairs
+# through `$dl -s -a ALGO' & print "Q\tI\tQUERY\tWORD\tDIST" for each, where
+# Q counts the queries from one & I the words from zero. Given K, print only
+# the pairs within K of one another.
+linear_scan() {
+    local words=$1 queries=$2 algo=$3 k=$4 pairs
+    pairs=$(awk 'NR == FNR { if ($0 != "" && $0 !~ /^#/) W[n++] = $0; next }
+                 $0 != "" && $0 !~ /^#/ {
+                     ++q
+                     for (i = 0; i < n; ++i) print q "\t" i "\t" $0 "\t" W[i]
+                 }' $words $queries)
+    paste <(echo "$pairs") \
+          <(echo "$pairs" | cut -f3,4 | $dl -s -a $algo ${k:+-k $k} | cut -f3) |
+        awk -F'\t' -v k="$k" 'k == "" || $5 <= k'
+}